@@ -2,10 +2,18 @@
 
 #include <thread>
 #include <atomic>
+#include <future>
+#include <memory>
+#include <functional>
+#include <deque>
+#include <condition_variable>
 #include "portaudio.h"
 #include "buffer.h"
 #include "modem_device.h"
 #include "packet.h"
+#include "frame.h"
+#include "link_adapter.h"
+#include "tx_scheduler.h"
 #include "modem_signal_sender.h"
 #include "portmixer.h"
 
@@ -18,6 +26,11 @@ struct modem_config {
 	modem_type device_type;
 	double input_volume;
 	double output_volume;
+	bool adaptive;
+	bool detect_baud;
+	fec_scheme fec;
+	int interleave;
+	bool compress;
 };
 
 struct io_buffer {
@@ -30,20 +43,54 @@ struct io_buffer {
 class audio_modem
 {
 private:
-	PaStream* stream;
+	std::atomic<PaStream*> stream;
 	modem_device* m_device;
-	io_buffer* buffer;
+	std::shared_ptr<io_buffer> buffer;
 	std::atomic_bool demod_flag;
 	packet_queue m_packet_queue;
 	PaDeviceIndex m_input_device, m_output_device;
 	modem_signal_sender m_signal_sender;
 
+	std::thread tx_thread;
+	std::atomic_bool tx_flag;
+	tx_scheduler m_scheduler;
+	std::mutex tx_mtx, device_mtx;
+	std::condition_variable tx_cv;
+	std::deque<std::vector<char>> m_sent;
+	uint8_t m_next_id;
+	// The frame the demodulation thread is checking, kept between frames so that none of them allocates.
+	std::vector<char> m_frame;
+
+	std::atomic_bool m_adaptive;
+	link_adapter m_link;
+	modem_device* m_tx_device;
+	std::atomic_bool m_detect_baud;
+	std::atomic<fec_scheme> m_fec;
+	std::atomic_int m_interleave;
+	std::atomic_bool m_compress;
+
 	static PaStreamCallback callback;
 	void demod_callback();
+	void tx_callback();
+	void request_repair(frame_assembler& assembler);
+	uint8_t allocate_id();
+	void resend(uint8_t id, const std::vector<uint16_t>& seqs, uint16_t from);
+	void protect(std::vector<char>& frames);
+	void interleave(std::vector<char>& frames);
+	size_t frame_payload() { return m_fec != fec_scheme::none ? fec_payload_size : frame_payload_size; }
 
 	int m_sample_rate;
 	int m_chunk_size;
 
+	static constexpr size_t tx_lookahead = 2;
+	static constexpr int adaptive_burst = 8;
+	static constexpr int burst_timeout_ms = 3000;
+	static constexpr size_t max_sent = 8;
+	static constexpr int repair_delay_ms = 3000;
+	static constexpr int group_timeout_ms = 1000;
+	static constexpr int burst_symbols = 128;
+	static constexpr int fade_symbols = 32;
+
 public:
 	audio_modem(int chunk_size, int sample_rate, modem_device* device = NULL);
 	~audio_modem();
@@ -55,6 +102,10 @@ public:
 
 	void modulate(char* src, size_t size);
 	void modulate(std::vector<char>& src);
+	std::future<bool> submit(std::vector<char> src, tx_priority priority = tx_priority::interactive);
+	void submit(std::vector<char> src, tx_priority priority, std::function<void(bool)> callback);
+	void broadcast(std::vector<char> src);
+	void stop_broadcast();
 
 	void set_chunk_size(int chunk_size);
 	void set_sample_rate(int sample_rate);
@@ -71,6 +122,11 @@ public:
 	int baud_rate() { return m_device->baud_rate(); }
 	bool audio_stream_operating() { return stream != NULL; }
 	bool demodulation_operating() { return demod_flag == true; }
+	bool adaptive() { return m_adaptive == true; }
+	bool detect_baud() { return m_detect_baud == true; }
+	fec_scheme fec() { return m_fec; }
+	int interleave_depth() { return m_interleave; }
+	bool compress() { return m_compress == true; }
 	PaDeviceIndex get_input_device() { return m_input_device; }
 	PaDeviceIndex get_output_device() { return m_output_device; }
 
@@ -0,0 +1,50 @@
+#pragma once
+#include "modem_device.h"
+#include "radix2_fft.h"
+#include <vector>
+
+class baud_estimator : public modem_device
+{
+private:
+	modem_device* prototype;
+	modem_device* device;
+	radix2_fft transform;
+	std::vector<double> re, im;
+	double noise_floor;
+	bool onset_found;
+	double m_tone;
+	int idle;
+	int tolerance;
+
+	static constexpr int block = 64;
+	static constexpr int fine_block = 16;
+	static constexpr int confirm_blocks = 4;
+	static constexpr int first_window = 96;
+	static constexpr size_t min_samples = 2048;
+	static constexpr double min_level = 0.05;
+	static constexpr double onset_ratio = 3;
+	static constexpr double min_purity = 0.4;
+	static constexpr double max_tone_error = 0.03;
+	static constexpr int max_idle = 64;
+
+	double energy(std::vector<short>& v, size_t start, size_t len);
+	double measure(std::vector<short>& v, size_t start, size_t len, double& purity);
+	double estimate(std::vector<short>& v);
+	int match_baud(double tone);
+
+public:
+	baud_estimator(modem_device* prototype);
+	~baud_estimator();
+
+	int sync(std::vector<short>& v);
+	int demoulate(std::vector<short>& v, std::vector<char>& dst);
+	int demoulate_soft(std::vector<short>& v, std::vector<char>& dst, std::vector<int8_t>& llr);
+	void modulate(char* src, size_t size, std::vector<short>& dst);
+	modem_device* new_device(int sample_rate, int baud_rate) { return new baud_estimator(prototype->new_device(sample_rate, baud_rate)); }
+	modem_type type() { return prototype->type(); }
+	int frame_length() { return prototype->frame_length(); }
+	void set_burst_tolerance(int symbols);
+
+	double tone() { return m_tone; }
+	int detected_baud_rate() { return device ? device->baud_rate() : 0; }
+};
\ No newline at end of file
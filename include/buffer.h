@@ -1,6 +1,10 @@
 #pragma once
 #include <mutex>
+#include <condition_variable>
+#include <chrono>
 #include <vector>
+#include <deque>
+#include <functional>
 
 using data_type = short;
 
@@ -29,16 +33,29 @@ public:
 
 class array_buffer {
 private:
+	struct entry {
+		std::vector<data_type> samples;
+		size_t offset;
+		std::function<void(bool)> done;
+	};
+
 	const int chunk_size;
 
-	std::vector<std::vector<data_type>> queue;
+	// Entries stay at the front after they are played, until complete() hands them back off the audio thread.
+	std::deque<entry> queue;
+	size_t played;
 	std::mutex m;
+	std::condition_variable drained;
 
 public:
-	array_buffer(int chunk_size) : chunk_size(chunk_size) {}
+	array_buffer(int chunk_size) : chunk_size(chunk_size), played(0) {}
+	~array_buffer() { clear(); }
 
 	bool empty();
-	void push(std::vector<data_type>&& src);
+	size_t size();
+	void push(std::vector<data_type>&& src, std::function<void(bool)> done = nullptr);
 	void pop(void* dst);
+	bool wait(size_t limit, std::chrono::milliseconds timeout);
+	void complete(std::vector<std::function<void(bool)>>& done);
 	void clear();
 };
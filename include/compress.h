@@ -0,0 +1,17 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include "packet.h"
+
+// LZ4 sequences: runs of literals, each followed by a match given as a 16-bit offset back and a length. Matches may
+// run to the very end, unlike in LZ4 proper, since short messages would otherwise keep their last 12 bytes raw.
+// A short hash chain finds the longest match. A dictionary, when given, is treated as text just before the input,
+// so matches may reach back into it.
+void lz_compress(const char* src, size_t size, std::vector<char>& dst, const char* dict = nullptr, size_t dict_size = 0);
+bool lz_decompress(const char* src, size_t size, std::vector<char>& dst, size_t max_size, const char* dict = nullptr, size_t dict_size = 0);
+
+// Replaces the body of a packet with its compressed form and sets packet_control::compressed, unless that would not
+// make it smaller. Text packets use the shared text dictionary. The caller seals the checksum afterwards.
+bool compress_packet(std::vector<char>& data);
+// Undoes compress_packet on a received packet; packets sent raw pass through. Fails on a body that does not expand.
+bool expand_packet(packet& p);
\ No newline at end of file
@@ -5,9 +5,11 @@
 #include <QComboBox>
 #include <QSlider>
 #include <QSpinBox>
+#include <QCheckBox>
 #include <QGridLayout>
 #include <vector>
 #include "audio_modem.h"
+#include "interleaver.h"
 #include "Windows.h"
 
 class config_window : public QWidget {
@@ -15,7 +17,7 @@ class config_window : public QWidget {
 
 public:
 	config_window(QWidget* parent, audio_modem& modem) : QWidget(parent), modem(modem) {
-		setFixedSize(330, 350);
+		setFixedSize(330, 525);
 		setWindowFlags(Qt::Window | Qt::WindowTitleHint | Qt::WindowCloseButtonHint);
 		setWindowTitle("Configuration");
 
@@ -25,12 +27,19 @@ public:
 		labelChunkSize = new QLabel("Audio Buffer Size", this);
 		labelDevice = new QLabel("Modem Device", this);
 		labelBaudRate = new QLabel("Baud Rate", this);
+		labelFec = new QLabel("Error Correction", this);
+		labelInterleave = new QLabel("Interleave Depth", this);
 		comboInput = new QComboBox(this);
 		comboOutput = new QComboBox(this);
 		comboSampleRate = new QComboBox(this);
 		comboChunkSize = new QComboBox(this);
 		comboDevice = new QComboBox(this);
+		comboFec = new QComboBox(this);
 		spinBaudRate = new QSpinBox(this);
+		spinInterleave = new QSpinBox(this);
+		checkAdaptive = new QCheckBox("Adapt rate to link quality", this);
+		checkDetectBaud = new QCheckBox("Detect sender baud rate", this);
+		checkCompress = new QCheckBox("Compress packets", this);
 		sliderInput = new QSlider(Qt::Horizontal, this);
 		sliderOutput = new QSlider(Qt::Horizontal, this);
 		buttonOk = new QPushButton("Confirm", this);
@@ -45,6 +54,8 @@ public:
 		layout->addWidget(labelChunkSize, 5, 0);
 		layout->addWidget(labelDevice, 6, 0);
 		layout->addWidget(labelBaudRate, 7, 0);
+		layout->addWidget(labelFec, 10, 0);
+		layout->addWidget(labelInterleave, 11, 0);
 		layout->addWidget(comboInput, 0, 1);
 		layout->addWidget(sliderInput, 1, 1);
 		layout->addWidget(comboOutput, 2, 1);
@@ -53,6 +64,11 @@ public:
 		layout->addWidget(comboChunkSize, 5, 1);
 		layout->addWidget(comboDevice, 6, 1);
 		layout->addWidget(spinBaudRate, 7, 1);
+		layout->addWidget(checkAdaptive, 8, 1);
+		layout->addWidget(checkDetectBaud, 9, 1);
+		layout->addWidget(comboFec, 10, 1);
+		layout->addWidget(spinInterleave, 11, 1);
+		layout->addWidget(checkCompress, 12, 1);
 
 		labelInput->setAlignment(Qt::AlignCenter);
 		labelOutput->setAlignment(Qt::AlignCenter);
@@ -60,12 +76,15 @@ public:
 		labelChunkSize->setAlignment(Qt::AlignCenter);
 		labelDevice->setAlignment(Qt::AlignCenter);
 		labelBaudRate->setAlignment(Qt::AlignCenter);
+		labelFec->setAlignment(Qt::AlignCenter);
+		labelInterleave->setAlignment(Qt::AlignCenter);
 
-		layoutWidget->setGeometry(10, 0, 310, 280);
-		buttonOk->setGeometry(70, 285, 80, 40);
-		buttonCancel->setGeometry(180, 285, 80, 40);
+		layoutWidget->setGeometry(10, 0, 310, 455);
+		buttonOk->setGeometry(70, 460, 80, 40);
+		buttonCancel->setGeometry(180, 460, 80, 40);
 
 		spinBaudRate->setRange(400, 3000);
+		spinInterleave->setRange(1, interleaver::max_depth);
 		sliderInput->setRange(0, 1000);
 		sliderOutput->setRange(0, 1000);
 
@@ -79,7 +98,9 @@ public:
 		comboSampleRate->clear();
 		comboChunkSize->clear();
 		comboDevice->clear();
+		comboFec->clear();
 		spinBaudRate->clear();
+		spinInterleave->clear();
 
 		modem_config config = modem.config();
 		std::vector<const PaDeviceInfo*> devices;
@@ -95,9 +116,17 @@ public:
 			comboDevice->addItem(modem_types[i]);
 		}
 
+		for (int i = 0; i < fec_scheme_count; ++i) {
+			comboFec->addItem(fec_schemes[i]);
+		}
+
 		comboChunkSize->addItems({ "1024", "2048", "4096", "8192" });
 		comboSampleRate->addItems({ "22050", "32000", "44100", "48000" });
 		spinBaudRate->setValue(config.baud_rate);
+		spinInterleave->setValue(config.interleave);
+		checkAdaptive->setChecked(config.adaptive);
+		checkDetectBaud->setChecked(config.detect_baud);
+		checkCompress->setChecked(config.compress);
 
 		if (config.input_volume < 0) {
 			sliderInput->setEnabled(false);
@@ -126,15 +155,17 @@ public:
 			comboSampleRate->setCurrentIndex(idxSampleRate);
 
 		comboDevice->setCurrentIndex((int)config.device_type);
+		comboFec->setCurrentIndex((int)config.fec);
 	}
 
 	~config_window() {}
 
 private:
-	QLabel* labelInput, * labelOutput, * labelSampleRate, * labelChunkSize, * labelDevice, * labelBaudRate;
-	QComboBox* comboInput, * comboOutput, * comboSampleRate, * comboChunkSize, * comboDevice;
+	QLabel* labelInput, * labelOutput, * labelSampleRate, * labelChunkSize, * labelDevice, * labelBaudRate, * labelFec, * labelInterleave;
+	QComboBox* comboInput, * comboOutput, * comboSampleRate, * comboChunkSize, * comboDevice, * comboFec;
 	QSlider* sliderInput, * sliderOutput;
-	QSpinBox *spinBaudRate;
+	QSpinBox *spinBaudRate, *spinInterleave;
+	QCheckBox* checkAdaptive, * checkDetectBaud, * checkCompress;
 	QPushButton* buttonOk, * buttonCancel;
 	QGridLayout* layout;
 	QWidget* layoutWidget;
@@ -149,6 +180,11 @@ public slots:
 		config.sample_rate = comboSampleRate->currentText().toInt();
 		config.device_type = (modem_type)comboDevice->currentIndex();
 		config.baud_rate = spinBaudRate->value();
+		config.adaptive = checkAdaptive->isChecked();
+		config.detect_baud = checkDetectBaud->isChecked();
+		config.fec = (fec_scheme)comboFec->currentIndex();
+		config.interleave = spinInterleave->value();
+		config.compress = checkCompress->isChecked();
 		config.input_volume = (double)sliderInput->value() / 1000;
 		config.output_volume = (double)sliderOutput->value() / 1000;
 
@@ -0,0 +1,30 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Rate 1/2, constraint length 7 convolutional code (generators 171 and 133 octal) with a soft-decision Viterbi decoder.
+// Soft values run from -127 to 127, positive leaning toward a 1 bit.
+class convolutional_code
+{
+private:
+	int16_t metrics[64], next[64];
+	int16_t sign0[32], sign1[32];
+	std::vector<uint64_t> decisions;
+
+	static constexpr int poly0 = 0171;
+	static constexpr int poly1 = 0133;
+
+	static int parity(int x);
+
+public:
+	static constexpr int constraint = 7;
+	static constexpr int tail = constraint - 1;
+
+	convolutional_code();
+
+	static size_t coded_bits(size_t size) { return 2 * (size * 8 + tail); }
+
+	void encode(const char* src, size_t size, std::vector<uint8_t>& dst);
+	void decode(const int8_t* soft, size_t size, char* dst);
+};
\ No newline at end of file
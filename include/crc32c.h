@@ -0,0 +1,6 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+// CRC-32C (Castagnoli). Pass a previous result as crc to continue over more data.
+uint32_t crc32c(const void* src, size_t size, uint32_t crc = 0);
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+#include "modem_device.h"
+#include "radix2_fft.h"
+#include <vector>
+#include <string>
+
+class css : public modem_device
+{
+private:
+	int spreading_factor;
+	int chips;
+	int samples_per_baud;
+	int min_samples;
+	int guard;
+	int max_volume;
+	int received;
+	double low_freq;
+	double base_freq;
+	double bandwidth;
+	double min_power;
+	double detect_contrast;
+	double timing_offset;
+	double timing_drift;
+	double tx_phase;
+
+	std::string buff;
+	radix2_fft transform;
+	std::vector<double> chirp_cos, chirp_sin;
+	std::vector<double> re, im, power;
+
+	static int symbol_size(int sample_rate, int baud_rate, int spreading_factor, double low_freq);
+
+	int detect(std::vector<short>& v, size_t idx, double& amplitude, double& contrast, double* offset = NULL);
+	void track(size_t& idx, double offset);
+	void write(int symbol, std::vector<short>& dst);
+
+public:
+	css(int sample_rate = 48000, int baud_rate = 600, int spreading_factor = 8, double low_freq = 1500);
+
+	int sync(std::vector<short>& v);
+	int demoulate(std::vector<short>& v, std::vector<char>& dst);
+	void modulate(char* src, size_t size, std::vector<short>& dst);
+	modem_device* new_device(int sample_rate, int baud_rate) { return new css(sample_rate, baud_rate, spreading_factor, low_freq); }
+	modem_type type() { return modem_type::css; }
+};
\ No newline at end of file
@@ -0,0 +1,12 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// rsync-style delta transfer. The side holding an old copy of a file describes it as a list of per-block signatures,
+// and the side holding the new copy answers with the blocks it could not find in that list plus references to the
+// ones it did, so an edit costs about the bytes it touched. Blocks are found at any offset through a rolling weak
+// checksum and confirmed with a CRC; the rebuilt file is checked against a CRC of the whole.
+void build_signatures(const char* basis, size_t size, std::vector<char>& dst);
+bool build_delta(const char* src, size_t size, const char* signatures, size_t sig_size, std::vector<char>& dst);
+bool apply_delta(const char* basis, size_t basis_size, const char* delta, size_t delta_size, std::vector<char>& dst);
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+#include "modem_device.h"
+#include <vector>
+#include <string>
+
+class dpsk : public modem_device
+{
+private:
+	modem_type m_type;
+	int bits_per_symbol;
+	int samples_per_baud;
+	int min_samples;
+	int max_volume;
+	int received;
+	int m_frame_length;
+	double threshold;
+	double prev_cos, prev_sin;
+	double timing_error;
+	double tx_phase;
+
+	std::string buff;
+	std::vector<double> _cos, _sin;
+
+	double transition(std::vector<short>& v, size_t idx);
+
+public:
+	dpsk(int sample_rate = 48000, int baud_rate = 600, modem_type type = modem_type::dqpsk, int frame_length = 4 * frame_size);
+
+	int sync(std::vector<short>& v);
+	int demoulate(std::vector<short>& v, std::vector<char>& dst);
+	void modulate(char* src, size_t size, std::vector<short>& dst);
+	modem_device* new_device(int sample_rate, int baud_rate) { return new dpsk(sample_rate, baud_rate, m_type, m_frame_length); }
+	modem_type type() { return m_type; }
+	int frame_length() { return m_frame_length; }
+	double preamble_tone() { return (double)m_sample_rate / samples_per_baud; }
+
+	void phase(std::vector<short>& v, size_t idx, double& cos, double& sin, size_t len = 0);
+	void write(double cos, double sin, std::vector<short>& dst);
+};
\ No newline at end of file
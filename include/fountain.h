@@ -0,0 +1,118 @@
+#pragma once
+#include <vector>
+#include <map>
+#include <deque>
+#include <cstdint>
+#include <cstddef>
+#include "packet.h"
+#include "frame.h"
+
+#pragma pack(push, 1)
+struct fountain_header {
+	uint32_t index;
+	uint16_t length;
+
+	fountain_header(uint32_t index = 0, uint16_t length = 0) : index(index), length(length) {}
+};
+#pragma pack(pop)
+
+constexpr size_t fountain_header_size = sizeof(fountain_header);
+
+// LT code over the blocks of one packet. Each symbol XORs a robust soliton number of blocks, picked from a sequence
+// seeded by the symbol index. Sending the plain blocks first would save clean receivers the decoding, but leaves
+// the blocks they missed to be found at random among later symbols.
+class fountain_code
+{
+private:
+	size_t k;
+	std::vector<double> cdf;
+
+	static constexpr double spike_c = 0.1;
+	static constexpr double failure = 0.5;
+
+public:
+	fountain_code(size_t blocks = 1);
+
+	size_t blocks() { return k; }
+	void neighbours(uint32_t index, std::vector<uint32_t>& dst);
+};
+
+// Turns a packet into an endless run of fountain frames; any set slightly larger than the packet rebuilds it.
+class fountain_encoder
+{
+private:
+	std::vector<char> data;
+	size_t symbol;
+	size_t length;
+	fountain_code code;
+	std::vector<uint32_t> picked;
+
+public:
+	fountain_encoder(const std::vector<char>& src, size_t payload = frame_payload_size);
+
+	void build_frame(uint32_t index, std::vector<char>& dst);
+};
+
+// Peels symbols as they come in. When peeling stalls with enough symbols held, the equations left move into a
+// reduced system over the blocks still unknown, and each later symbol is eliminated against it as it arrives.
+class fountain_decoder
+{
+private:
+	struct equation {
+		std::vector<uint32_t> blocks;
+		std::vector<char> data;
+	};
+
+	size_t symbol;
+	size_t length;
+	fountain_code code;
+	std::vector<char> data;
+	std::vector<bool> known;
+	std::vector<equation> equations;
+	std::vector<std::vector<uint32_t>> watching;
+	std::vector<uint32_t> picked, queue;
+	size_t m_received, m_recovered;
+
+	// The reduced system: one bit row and symbol sum per independent equation, each row holding the only set bit
+	// of its pivot column. Columns number the blocks that were unknown when elimination began.
+	bool solving;
+	size_t words;
+	std::vector<uint32_t> unknown, pivots;
+	std::vector<int> column, pivot_row;
+	std::vector<uint64_t> bits;
+	std::vector<char> sums;
+
+	void resolve(uint32_t block, const char* src);
+	void peel();
+	void eliminate();
+	void reduce(const std::vector<uint32_t>& blocks, const char* src);
+
+public:
+	fountain_decoder(size_t length = 0, size_t symbol = 1);
+
+	bool push(uint32_t index, const char* src);
+	bool finished() { return m_recovered == code.blocks(); }
+	size_t received() { return m_received; }
+	size_t recovered() { return std::min(m_recovered * symbol, length); }
+	size_t packet_length() { return length; }
+	std::vector<char> packet_data();
+};
+
+class fountain_assembler
+{
+private:
+	static constexpr size_t max_pending = 4;
+	static constexpr size_t max_done = 16;
+
+	std::map<uint32_t, fountain_decoder> pending;
+	std::deque<uint32_t> order, done;
+	fountain_decoder* m_current;
+	size_t payload;
+
+public:
+	fountain_assembler(size_t payload = frame_payload_size) : m_current(NULL), payload(payload) {}
+
+	packet* push(const char* frame);
+	bool progress(size_t& received, size_t& length);
+	void clear();
+};
\ No newline at end of file
@@ -0,0 +1,88 @@
+#pragma once
+#include <vector>
+#include <map>
+#include "packet.h"
+#include "modem_device.h"
+
+enum class frame_type : uint8_t {
+	data = 0b00000001,
+	mode = 0b00000010,
+	nack = 0b00000100,
+	fill = 0b00001000,
+	fountain = 0b00010000
+};
+
+#pragma pack(push, 1)
+struct frame_header {
+	uint8_t id;
+	uint8_t type;
+	uint16_t seq;
+	uint32_t crc;
+
+	frame_header(uint8_t id = 0, frame_type type = frame_type::data, uint16_t seq = 0) : id(id), type((uint8_t)type), seq(seq), crc(0) {}
+};
+
+struct nack_header {
+	uint16_t from;
+
+	nack_header(uint16_t from = 0) : from(from) {}
+};
+#pragma pack(pop)
+
+constexpr size_t frame_header_size = sizeof(frame_header);
+constexpr size_t frame_payload_size = frame_size - frame_header_size;
+constexpr uint16_t no_seq = UINT16_MAX;
+
+// With error correction on, the last bytes of every frame hold parity and the payload shrinks to match. Both codes
+// are rate 3/4 over the whole frame; LDPC decodes the demodulator's soft bits and holds up at lower SNR.
+enum class fec_scheme {
+	none,
+	reed_solomon,
+	ldpc
+};
+
+constexpr int fec_scheme_count = 3;
+constexpr const char* fec_schemes[fec_scheme_count] = { "None", "Reed-Solomon", "LDPC" };
+constexpr size_t fec_parity_size = 32;
+constexpr size_t fec_payload_size = frame_payload_size - fec_parity_size;
+
+size_t frame_count(size_t packet_size, size_t payload = frame_payload_size);
+void build_frame(const std::vector<char>& src, uint16_t seq, std::vector<char>& dst, size_t payload = frame_payload_size);
+void seal_frame(char* frame);
+bool frame_intact(const char* frame);
+void build_fill_frame(std::vector<char>& dst);
+void protect_frame(char* frame, fec_scheme scheme = fec_scheme::reed_solomon);
+// Corrects a protected frame and reports whether it now passes its CRC. Per-bit LLRs from the demodulator, when
+// given, let Reed-Solomon erase the least reliable bytes and feed the LDPC decoder directly.
+bool repair_frame(char* frame, const int8_t* llr = nullptr, fec_scheme scheme = fec_scheme::reed_solomon);
+
+// Asks the sender of packet id for the listed frames, and for every frame from `from` on unless it is no_seq.
+// The list travels as a bitmap over the payload; frames past its end are covered by lowering `from`.
+void build_nack_frame(uint8_t id, const std::vector<uint16_t>& seqs, uint16_t from, std::vector<char>& dst, size_t payload = frame_payload_size);
+bool parse_nack_frame(const char* frame, uint8_t& id, std::vector<uint16_t>& seqs, uint16_t& from, size_t payload = frame_payload_size);
+
+class frame_assembler
+{
+private:
+	struct partial {
+		std::map<uint16_t, std::vector<char>> frames;
+		size_t length = 0;
+		int requests = 0;
+	};
+
+	static constexpr int max_requests = 3;
+
+	std::map<uint8_t, partial> pending;
+	partial* m_current;
+	size_t payload;
+
+public:
+	frame_assembler(size_t payload = frame_payload_size) : m_current(NULL), payload(payload) {}
+
+	packet* push(const char* frame);
+	std::vector<uint8_t> incomplete();
+	bool missing(uint8_t id, std::vector<uint16_t>& seqs, uint16_t& from);
+	bool progress(size_t& received, size_t& length);
+	void drop(uint8_t id);
+	void clear();
+};
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 #include "modem_device.h"
+#include "convolutional.h"
 #include <vector>
 #include <string>
 
@@ -10,21 +11,35 @@ private:
 	int min_samples;
 	int max_volume;
 	int received;
+	int carrier;
+	double volume;
 	double threshold;
+	bool coded;
+	int weak;
+	int tolerance;
 	
 	std::string buff;
+	std::vector<int8_t> soft;
+	convolutional_code code;
 	std::vector<double> hi_cos, lo_cos;
 	std::vector<double> hi_sin, lo_sin;
 	std::vector<short> high, low;
 
+	static constexpr int max_weak = 3;
+
+	size_t align(std::vector<short>& v, size_t origin, long long step);
+
 public:
-	fsk(int sample_rate = 48000, int baud_rate = 600);
+	fsk(int sample_rate = 48000, int baud_rate = 600, int carrier = 1, double volume = 0.9, bool coded = false);
 
 	int sync(std::vector<short>& v);
 	int demoulate(std::vector<short>& v, std::vector<char>& dst);
+	int demoulate_soft(std::vector<short>& v, std::vector<char>& dst, std::vector<int8_t>& llr);
 	void modulate(char* src, size_t size, std::vector<short>& dst);
-	modem_device* new_device(int sample_rate, int baud_rate) { return new fsk(sample_rate, baud_rate); }
-	modem_type type() { return modem_type::fsk; }
+	modem_device* new_device(int sample_rate, int baud_rate) { return new fsk(sample_rate, baud_rate, carrier, volume, coded); }
+	modem_type type() { return coded ? modem_type::fsk_coded : modem_type::fsk; }
+	double preamble_tone() { return (double)carrier * m_sample_rate / samples_per_baud; }
+	void set_burst_tolerance(int symbols) { tolerance = symbols; }
 	
 	void fft(std::vector<short>& v, size_t idx, double& hi, double& lo);
 	void phase(std::vector<short>& v, size_t idx, double& cos, double& sin, size_t len = 0);
@@ -0,0 +1,29 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Block interleaver over groups of whole frames. A group is written one frame per row and sent column by column, so
+// a burst on the air lands as a few bytes in every frame of the group instead of many in one. The receive side keeps
+// its buffers between groups, so deinterleaving does not allocate once they have grown to size.
+class interleaver
+{
+private:
+	int depth;
+	int filled;
+	std::vector<char> rows;
+	std::vector<int8_t> row_llr;
+
+public:
+	static constexpr int max_depth = 8;
+
+	interleaver(int depth = 1);
+
+	int group_frames() { return depth; }
+	int pending() { return filled; }
+
+	void interleave(const char* src, char* dst);
+	bool push(const char* frame, const int8_t* llr);
+	void pop(std::vector<char>& dst, std::vector<int8_t>& llr);
+	void reset() { filled = 0; }
+};
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+enum class ldpc_rate { half, three_quarters, seven_eighths };
+
+// Quasi-cyclic LDPC codes over a 32-column base matrix. Every base entry stands for a z by z shifted identity, so a
+// block is 32 * z bits. The parity part is dual-diagonal as in 802.11n, which makes encoding a linear pass.
+// LLRs run from -127 to 127, positive leaning toward a 1 bit, eight per byte with the most significant bit first.
+class ldpc_code
+{
+private:
+	struct edge {
+		int column;
+		int shift;
+	};
+
+	int z;
+	int rows, columns;
+	std::vector<std::vector<edge>> layers;
+	std::vector<int16_t> app, messages, extrinsic, rotated;
+
+	void build();
+	bool satisfied();
+
+public:
+	static constexpr int base_columns = 32;
+	static constexpr int max_iterations = 20;
+
+	ldpc_code(int z = 32, ldpc_rate rate = ldpc_rate::three_quarters);
+
+	size_t block_bits() { return (size_t)columns * z; }
+	size_t data_bits() { return (size_t)(columns - rows) * z; }
+	size_t parity_bits() { return (size_t)rows * z; }
+
+	void encode(const uint8_t* msg, uint8_t* parity);
+	bool decode(const int8_t* llr, uint8_t* dst, int iterations = max_iterations);
+};
\ No newline at end of file
@@ -0,0 +1,69 @@
+#pragma once
+#include <vector>
+#include <mutex>
+#include "modem_device.h"
+#include "frame.h"
+
+struct link_mode {
+	modem_type type;
+	int baud_rate;
+	double min_snr;
+};
+
+// Ordered by throughput, each with the SNR in dB it needs to hold its frames.
+constexpr int link_mode_count = 5;
+constexpr link_mode link_modes[link_mode_count] = {
+	{ modem_type::fsk, 600, 0 },
+	{ modem_type::qpsk, 1225, 6 },
+	{ modem_type::psk8, 2400, 9 },
+	{ modem_type::qam16, 2400, 16 },
+	{ modem_type::ofdm, 1225, 26 }
+};
+
+#pragma pack(push, 1)
+struct link_report {
+	uint8_t snr;
+	uint8_t loss;
+
+	link_report(uint8_t snr = UINT8_MAX, uint8_t loss = 0) : snr(snr), loss(loss) {}
+};
+
+struct mode_header {
+	uint8_t device_type;
+	uint16_t baud_rate;
+	uint16_t frames;
+	link_report report;
+
+	mode_header(modem_type type = modem_type::fsk, int baud_rate = 0, int frames = 0, link_report report = link_report()) :
+		device_type((uint8_t)type), baud_rate((uint16_t)baud_rate), frames((uint16_t)frames), report(report) {}
+};
+#pragma pack(pop)
+
+void build_mode_frame(const mode_header& header, std::vector<char>& dst);
+bool parse_mode_frame(const char* frame, mode_header& dst);
+
+class link_adapter
+{
+private:
+	std::mutex m;
+	int level;
+	int good_reports;
+	double noise_power;
+	double signal_power;
+	double loss;
+
+	static constexpr double step_up_margin = 3;
+	static constexpr int step_up_reports = 3;
+	static constexpr double max_loss = 0.1;
+
+public:
+	link_adapter() { reset(); }
+
+	void measure(const std::vector<short>& v, bool in_frame);
+	void frame_received();
+	void frame_lost();
+	void feedback(const link_report& report);
+	link_report report();
+	link_mode mode();
+	void reset();
+};
\ No newline at end of file
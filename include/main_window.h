@@ -10,7 +10,7 @@
 #include <QKeyEvent>
 #include <QtCore/QTimer>
 #include <QScrollBar>
-#include <random>
+#include <map>
 #include "audio_modem.h"
 #include "info_window.h"
 #include "config_window.h"
@@ -47,7 +47,6 @@ public:
 
 private:
     audio_modem modem;
-    std::mt19937 engine;
 
     QBoxLayout* hLayout, *vLayout;
     QMenuBar* menuBar;
@@ -56,7 +55,7 @@ private:
     QPushButton* buttonSend, *buttonFile;
     QTextEdit* textLog;
     MyTextEdit* textInput;
-    QAction* actionFile, * actionExport;
+    QAction* actionFile, * actionUpdate, * actionBroadcast, * actionStopBroadcast, * actionExport;
     QAction* actionModemDevice, * actionConfig;
     QVector<QAction*> actionDevices;
     QAction* actionInfo;
@@ -64,6 +63,19 @@ private:
     info_window* windowInfo;
     config_window* windowConfig;
 
+    // Files offered as updates, by name, until the receiver answers with the signatures of its copy.
+    std::map<std::string, packet> offers;
+
+    static constexpr int offer_timeout_ms = 20000;
+
+    bool read_file(const QString& dir, packet& p);
+    void send_packet(uint8_t control, const file_header& head, const std::vector<char>& data, tx_priority priority);
+    void receive_file(packet* p);
+    void save_file(const file_header& head, const char* data);
+    void answer_offer(const file_header& head);
+    void send_changes(const file_header& head, const char* signatures, size_t sig_size);
+    void apply_changes(const file_header& head, const char* delta, size_t size);
+
 public slots:
     void start_audio_stream();
     void start_demodulation_service();
@@ -71,6 +83,9 @@ public slots:
     void stop_demodulation_service();
     void send_msg();
     void send_file();
+    void update_file();
+    void broadcast_file();
+    void stop_broadcast();
     void receiving_packet(int received, int packet_length);
     void receive_packet();
     void translate_packet(packet* p);
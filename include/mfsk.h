@@ -0,0 +1,41 @@
+#pragma once
+#include "modem_device.h"
+#include "radix2_fft.h"
+#include <vector>
+#include <string>
+
+class mfsk : public modem_device
+{
+private:
+	int tones;
+	int spacing;
+	int bits_per_symbol;
+	int samples_per_baud;
+	int base_bin;
+	int min_samples;
+	int max_volume;
+	int received;
+	double base_freq;
+	double threshold;
+
+	std::string buff;
+	radix2_fft transform;
+	std::vector<std::vector<short>> waves;
+	std::vector<double> re, im;
+	std::vector<int> gray, symbol_of;
+
+	static int symbol_size(int sample_rate, int baud_rate, int tones, int spacing, double base_freq);
+
+	int bin(int tone) { return base_bin + tone * spacing; }
+	double amplitude(std::vector<short>& v, size_t idx, int tone);
+	int detect(std::vector<short>& v, size_t idx, double& power, double& contrast);
+
+public:
+	mfsk(int sample_rate = 48000, int baud_rate = 600, int tones = 16, int spacing = 2, double base_freq = 1500);
+
+	int sync(std::vector<short>& v);
+	int demoulate(std::vector<short>& v, std::vector<char>& dst);
+	void modulate(char* src, size_t size, std::vector<short>& dst);
+	modem_device* new_device(int sample_rate, int baud_rate) { return new mfsk(sample_rate, baud_rate, tones, spacing, base_freq); }
+	modem_type type() { return modem_type::mfsk; }
+};
\ No newline at end of file
@@ -1,15 +1,31 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <cstdint>
 
 constexpr double pi = 3.1415926535897931;
 constexpr int inf = 987654321;
-constexpr int modem_type_count = 2;
-constexpr const char* modem_types[modem_type_count] = { "FSK", "QPSK"};
+constexpr int frame_size = 128;
+constexpr double sqr = 0.70710678118;
+constexpr int8_t max_llr = 127;
+constexpr int modem_type_count = 14;
+constexpr const char* modem_types[modem_type_count] = { "FSK", "QPSK", "OFDM", "8PSK", "16QAM", "MFSK", "DBPSK", "DQPSK", "CSS", "FSK-MC", "QPSK-MC", "AUTO", "FSK-CC", "QPSK-CC" };
 
 enum class modem_type { 
 	fsk, 
-	qpsk 
+	qpsk,
+	ofdm,
+	psk8,
+	qam16,
+	mfsk,
+	dbpsk,
+	dqpsk,
+	css,
+	fsk_multi,
+	qpsk_multi,
+	auto_rx,
+	fsk_coded,
+	qpsk_coded
 };
 
 class modem_device {
@@ -18,15 +34,24 @@ protected:
 	int m_sample_rate;
 	int m_baud_rate;
 
+	static void hard_llr(const char* src, size_t size, std::vector<int8_t>& dst);
+
 public:
 	modem_device(int sample_rate, int baud_rate) : synchronized(false), m_sample_rate(sample_rate), m_baud_rate(baud_rate) {};
+	virtual ~modem_device() {}
 	static modem_device* new_device(modem_type type, int sample_rate, int baud_rate);
 
 	virtual int sync(std::vector<short>& v) = 0;
 	virtual int demoulate(std::vector<short>& v, std::vector<char>& dst) = 0;
+	virtual int demoulate_soft(std::vector<short>& v, std::vector<char>& dst, std::vector<int8_t>& llr);
 	virtual void modulate(char* src, size_t size, std::vector<short>& dst) = 0;
 	virtual modem_device* new_device(int sample_rate, int baud_rate) = 0;
 	virtual modem_type type() = 0;
+	virtual int frame_length() { return frame_size; }
+	virtual double preamble_tone() { return 0; }
+
+	// How many faint symbols in a row a frame may hold before it is dropped; interleaving or a retransmission makes up for them later.
+	virtual void set_burst_tolerance(int) {}
 
 	void modulate(std::vector<char>& src, std::vector<short>& dst) { modulate(src.data(), src.size(), dst); }
 	int sample_rate() { return m_sample_rate; }
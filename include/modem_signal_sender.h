@@ -14,4 +14,5 @@ signals:
 	void packet_lost();
 	void debug_packet();
 	void packet_received();
+	void packet_sent();
 };
\ No newline at end of file
@@ -0,0 +1,34 @@
+#pragma once
+#include "modem_device.h"
+#include <vector>
+
+class multi_carrier : public modem_device
+{
+private:
+	struct lane {
+		modem_device* device;
+		std::vector<short> samples;
+		std::vector<char> received;
+	};
+
+	modem_type m_type;
+	int m_carriers;
+	int m_first_carrier;
+	std::vector<lane> lanes;
+
+	static int max_carriers(int sample_rate, int baud_rate, modem_type type, int first_carrier);
+
+	void feed(std::vector<short>& v);
+	int step(lane& l, std::vector<char>& dst);
+
+public:
+	multi_carrier(int sample_rate = 48000, int baud_rate = 600, modem_type type = modem_type::fsk_multi, int carriers = 4, int first_carrier = 2);
+	~multi_carrier();
+
+	int sync(std::vector<short>& v);
+	int demoulate(std::vector<short>& v, std::vector<char>& dst);
+	void modulate(char* src, size_t size, std::vector<short>& dst);
+	modem_device* new_device(int sample_rate, int baud_rate) { return new multi_carrier(sample_rate, baud_rate, m_type, m_carriers, m_first_carrier); }
+	modem_type type() { return m_type; }
+	int frame_length() { return (int)lanes.size() * frame_size; }
+};
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+#include "modem_device.h"
+#include "frame.h"
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+struct receiver_hypothesis {
+	modem_type type;
+	int baud_rate;
+};
+
+class multi_receiver : public modem_device
+{
+private:
+	struct lane {
+		modem_device* device;
+		std::vector<short> input;
+		std::vector<char> output;
+		std::vector<int8_t> output_llr;
+		std::vector<bool> passed;
+		std::thread worker;
+	};
+
+	std::vector<receiver_hypothesis> m_hypotheses;
+	std::vector<lane*> lanes;
+	lane* active;
+	std::deque<std::vector<char>> recent;
+	std::mutex m;
+	std::condition_variable cv;
+	bool stop;
+	int tolerance;
+	fec_scheme m_fec;
+
+	static constexpr size_t min_block = 4096;
+	static constexpr size_t max_recent = 64;
+
+	void run(lane* l);
+
+public:
+	multi_receiver(int sample_rate = 48000, int baud_rate = 600, const std::vector<receiver_hypothesis>& hypotheses = {});
+	~multi_receiver();
+
+	int sync(std::vector<short>& v);
+	int demoulate(std::vector<short>& v, std::vector<char>& dst);
+	int demoulate_soft(std::vector<short>& v, std::vector<char>& dst, std::vector<int8_t>& llr);
+	void modulate(char* src, size_t size, std::vector<short>& dst);
+	modem_device* new_device(int sample_rate, int baud_rate) { return new multi_receiver(sample_rate, baud_rate, m_hypotheses); }
+	modem_type type() { return modem_type::auto_rx; }
+	int frame_length() { return lanes[0]->device->frame_length(); }
+	void set_burst_tolerance(int symbols);
+	void set_fec(fec_scheme scheme);
+};
\ No newline at end of file
@@ -0,0 +1,50 @@
+#pragma once
+#include "modem_device.h"
+#include "radix2_fft.h"
+#include <vector>
+#include <string>
+
+class ofdm : public modem_device
+{
+private:
+	int requested_fft_size;
+	int requested_prefix;
+	int fft_size;
+	int cyclic_prefix;
+	int symbol_len;
+	int backoff;
+	int min_samples;
+	int max_volume;
+	int received;
+	int pilot_spacing;
+	double low_freq, high_freq;
+	double threshold;
+	double scale;
+
+	std::string buff;
+	radix2_fft transform;
+	std::vector<int> carriers;
+	std::vector<bool> is_pilot;
+	std::vector<double> preamble_re, preamble_im;
+	std::vector<double> pilot_value;
+	std::vector<double> channel_re, channel_im;
+	std::vector<short> preamble;
+	std::vector<double> re, im;
+
+	static int default_fft_size(int sample_rate, int baud_rate);
+
+	void write(std::vector<double>& x_re, std::vector<double>& x_im, std::vector<short>& dst);
+	void spectrum(std::vector<short>& v, size_t idx);
+
+public:
+	ofdm(int sample_rate = 48000, int baud_rate = 600, int fft_size = 0, int cyclic_prefix = 0,
+		double low_freq = 1200, double high_freq = 12000, int pilot_spacing = 6);
+
+	int sync(std::vector<short>& v);
+	int demoulate(std::vector<short>& v, std::vector<char>& dst);
+	void modulate(char* src, size_t size, std::vector<short>& dst);
+	modem_device* new_device(int sample_rate, int baud_rate) { return new ofdm(sample_rate, baud_rate, requested_fft_size, requested_prefix, low_freq, high_freq, pilot_spacing); }
+	modem_type type() { return modem_type::ofdm; }
+
+	int bits_per_symbol();
+};
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 #include <vector>
+#include <string>
 #include <mutex>
 #include <QtCore/QObject>
 
@@ -7,7 +8,11 @@ constexpr size_t MAX_FILENAME_LEN = 256;
 
 enum packet_control {
 	text = 0b00000001,
-	file = 0b00000010
+	file = 0b00000010,
+	file_offer = 0b00000100,
+	file_signature = 0b00001000,
+	file_delta = 0b00010000,
+	compressed = 0b10000000
 };
 
 #pragma pack(push, 1)
@@ -15,24 +20,36 @@ struct packet_header {
 	uint8_t id;
 	uint8_t control;
 	uint16_t len;
-	uint16_t checksum;
+	uint32_t checksum;
 
 	packet_header() : id(0), control(0), len(0), checksum(0) {}
 	bool operator==(packet_header& other) { return memcmp(this, &other, sizeof(packet_header)) == 0; }
 };
 
+#pragma pack(pop)
+
+// Goes in front of a file's bytes: the name's length and the name, the data length, then optional fields, each a tag
+// byte and a varint, closed by a zero tag. Tags a receiver does not know are skipped.
 struct file_header {
-	char file_name[MAX_FILENAME_LEN];
-	int data_length;
+	static constexpr uint8_t tag_end = 0;
+	static constexpr uint8_t tag_modified = 1;
+	static constexpr uint8_t tag_hash = 2;
+
+	std::string file_name;
+	size_t data_length;
+	uint64_t modified;	// Seconds since the epoch; 0 when not sent.
+	uint32_t hash;		// CRC-32C of the data; 0 when not sent.
+
+	file_header(const std::string& file_name = "", size_t len = 0) : file_name(file_name), data_length(len), modified(0), hash(0) {}
 
-	file_header(const std::string& file_name = "", int len = 0) : data_length(len) { 
-		std::strcpy(this->file_name, file_name.c_str());
-	}
+	void encode(std::vector<char>& dst) const;
+	size_t decode(const char* src, size_t size);
+
+	// Whether a received name can be used as a file name directly inside the receive folder on every platform.
+	static bool safe_name(const std::string& name);
 };
-#pragma pack(pop)
 
 constexpr size_t header_size = sizeof(packet_header);
-constexpr size_t file_header_size = sizeof(file_header);
 constexpr size_t max_packet_size = UINT16_MAX;
 constexpr size_t max_data_size = max_packet_size - header_size;
 
@@ -52,11 +69,13 @@ public:
 
 	void clear() { m_data.clear(); }
 	void push(const void* src, size_t size);
-	void push(std::vector<char>& v);
 	bool finished();
 	bool valid();
 	size_t size() { return m_data.size(); }
-	uint16_t checksum();
+	uint32_t checksum();
+
+	static uint32_t checksum(const std::vector<char>& data);
+	static void seal(std::vector<char>& data);
 
 	packet_header* header();
 	char* data() { return m_data.data() + header_size;  }
@@ -0,0 +1,42 @@
+#pragma once
+#include "modem_device.h"
+#include "qpsk.h"
+#include <vector>
+#include <string>
+
+class qam : public modem_device
+{
+private:
+	modem_type m_type;
+	int bits_per_symbol;
+	int samples_per_baud;
+	int min_samples;
+	int max_volume;
+	int received;
+	double min_power;
+	double ref_cos, ref_sin;
+
+	std::string buff;
+	std::vector<double> _cos, _sin;
+	std::vector<double> point_cos, point_sin;
+	std::vector<int> gray;
+
+	// The preamble is QPSK's, so a QPSK device finds it.
+	qpsk acquire;
+
+	int decide(double cos, double sin);
+	void normalize(double& cos, double& sin);
+
+public:
+	qam(int sample_rate = 48000, int baud_rate = 600, modem_type type = modem_type::qam16);
+
+	int sync(std::vector<short>& v);
+	int demoulate(std::vector<short>& v, std::vector<char>& dst);
+	void modulate(char* src, size_t size, std::vector<short>& dst);
+	modem_device* new_device(int sample_rate, int baud_rate) { return new qam(sample_rate, baud_rate, m_type); }
+	modem_type type() { return m_type; }
+	double preamble_tone() { return (double)m_sample_rate / samples_per_baud; }
+
+	void phase(std::vector<short>& v, size_t idx, double& cos, double& sin, size_t len = 0);
+	void write(double cos, double sin, std::vector<short>& dst);
+};
\ No newline at end of file
@@ -1,10 +1,9 @@
 #pragma once
 #include "modem_device.h"
+#include "convolutional.h"
 #include <vector>
 #include <string>
 
-constexpr double sqr = 0.70710678118;
-
 class qpsk : public modem_device
 {
 private:
@@ -12,19 +11,37 @@ private:
 	int min_samples;
 	int max_volume;
 	int received;
+	int carrier;
+	double volume;
 	double threshold;
+	bool coded;
+	int weak;
+	int tolerance;
+	double ref_cos, ref_sin;
+	double pre_cos, pre_sin;
 
 	std::string buff;
+	std::vector<int8_t> soft;
+	convolutional_code code;
 	std::vector<double> _cos, _sin;
 
+	static constexpr int max_weak = 3;
+
+	size_t align(std::vector<short>& v, size_t origin, long long step);
+
 public:
-	qpsk(int sample_rate = 48000, int baud_rate = 600);
+	qpsk(int sample_rate = 48000, int baud_rate = 600, int carrier = 1, double volume = 0.9, bool coded = false);
 
 	int sync(std::vector<short>& v);
 	int demoulate(std::vector<short>& v, std::vector<char>& dst);
+	int demoulate_soft(std::vector<short>& v, std::vector<char>& dst, std::vector<int8_t>& llr);
 	void modulate(char* src, size_t size, std::vector<short>& dst);
-	modem_device* new_device(int sample_rate, int baud_rate) { return new qpsk(sample_rate, baud_rate); }
-	modem_type type() { return modem_type::qpsk; }
+	modem_device* new_device(int sample_rate, int baud_rate) { return new qpsk(sample_rate, baud_rate, carrier, volume, coded); }
+	modem_type type() { return coded ? modem_type::qpsk_coded : modem_type::qpsk; }
+	double preamble_tone() { return (double)carrier * m_sample_rate / samples_per_baud; }
+	void set_burst_tolerance(int symbols) { tolerance = symbols; }
+	// The reference symbols just before the marker of the last preamble found, as received.
+	void preamble(double& cos, double& sin) { cos = pre_cos; sin = pre_sin; }
 
 	void phase(std::vector<short>& v, size_t idx, double& cos, double& sin, size_t len = 0);
 	void write(double cos, double sin, std::vector<short>& dst);
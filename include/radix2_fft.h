@@ -0,0 +1,21 @@
+#pragma once
+#include <vector>
+
+class radix2_fft
+{
+private:
+	int n;
+	std::vector<int> reversed;
+	std::vector<double> w_re, w_im;
+
+	void transform(double* re, double* im);
+
+public:
+	radix2_fft(int n);
+
+	void forward(std::vector<double>& re, std::vector<double>& im);
+	void inverse(std::vector<double>& re, std::vector<double>& im);
+	int size() { return n; }
+
+	static bool is_power_of_two(int n) { return n > 0 && (n & (n - 1)) == 0; }
+};
\ No newline at end of file
@@ -0,0 +1,24 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+// Systematic Reed-Solomon code over GF(256), shortened to any block of up to 255 bytes.
+// decode returns the number of corrected bytes, or -1 when the block has more errors than parity / 2. Positions known
+// to be unreliable can be passed as erasures, each of which costs one parity byte instead of two.
+class reed_solomon
+{
+private:
+	static constexpr int max_parity = 32;
+
+	int parity;
+	uint8_t generator[max_parity + 1];
+
+	void syndromes(const uint8_t* block, size_t len, uint8_t* dst);
+
+public:
+	reed_solomon(int parity = max_parity);
+
+	void encode(const uint8_t* msg, size_t len, uint8_t* dst);
+	int decode(uint8_t* block, size_t len, const size_t* erasures = nullptr, int count = 0);
+	int parity_size() { return parity; }
+};
\ No newline at end of file
@@ -0,0 +1,34 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <cstdint>
+#include <cstddef>
+#include "frame.h"
+
+// Chase combining for frames that fail to decode. Their soft bits are kept, and a later copy of the same frame adds
+// its LLRs to them before decoding again, so the energy of every attempt counts. Frames of one packet look much alike,
+// so copies are only added up when their headers name the same frame. A copy whose header took a hit is still tried
+// against every kept frame its bits mostly agree with, since the CRC has the last word, but it is kept apart.
+class soft_combiner
+{
+private:
+	std::deque<std::vector<int16_t>> kept;
+	std::vector<int8_t> combined;
+	std::vector<size_t> candidates;
+
+	static constexpr size_t max_kept = 32;
+	static constexpr double min_agreement = 0.7;
+
+	static constexpr size_t header_bits = offsetof(frame_header, crc) * 8;
+
+	double agreement(const std::vector<int16_t>& sum, const int8_t* llr);
+	bool same_header(const std::vector<int16_t>& sum, const int8_t* llr);
+
+public:
+	soft_combiner() : combined(frame_size * 8) {}
+
+	// Called with a frame that failed; on success the frame holds the repaired copy.
+	bool combine(char* frame, const int8_t* llr, fec_scheme scheme);
+	void clear() { kept.clear(); }
+	bool empty() { return kept.empty(); }
+};
\ No newline at end of file
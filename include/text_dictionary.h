@@ -0,0 +1,7 @@
+#pragma once
+#include <cstddef>
+
+// Text both ends hold before any packet is sent. Short messages are compressed as if it came just before them, so
+// their common words and phrases cost a back reference instead of the letters.
+extern const char text_dictionary[];
+extern const size_t text_dictionary_size;
\ No newline at end of file
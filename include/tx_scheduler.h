@@ -0,0 +1,43 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <functional>
+#include <cstdint>
+#include "frame.h"
+
+enum class tx_priority {
+	control,
+	interactive,
+	bulk
+};
+
+constexpr int tx_priority_count = 3;
+
+class tx_scheduler
+{
+private:
+	struct entry {
+		std::vector<char> data;
+		std::function<void(bool)> callback;
+		std::vector<uint16_t> seqs;
+		size_t next;
+		size_t payload;
+		bool framed;
+		std::function<void(std::vector<char>&)> source;
+	};
+
+	std::deque<entry> queues[tx_priority_count];
+
+public:
+	tx_scheduler() {}
+
+	bool empty();
+	void push(std::vector<char>&& data, tx_priority priority, std::function<void(bool)> callback, size_t payload = frame_payload_size);
+	void resend(const std::vector<char>& data, std::vector<uint16_t>&& seqs, tx_priority priority, size_t payload = frame_payload_size);
+	void push_frame(std::vector<char>&& frame, tx_priority priority);
+	// A stream builds its frames on demand and stays queued until end_streams, taking turns like any other entry.
+	void push_stream(std::function<void(std::vector<char>&)> source, tx_priority priority);
+	void end_streams();
+	bool pop(std::vector<char>& frame, std::function<void(bool)>& callback);
+	void clear();
+};
\ No newline at end of file
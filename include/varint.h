@@ -0,0 +1,32 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// LEB128: seven bits per byte, least significant group first, the top bit set on every byte but the last.
+inline void put_varint(uint64_t v, std::vector<char>& dst) {
+	for (; v >= 0x80; v >>= 7)
+		dst.push_back((char)((v & 0x7f) | 0x80));
+
+	dst.push_back((char)v);
+}
+
+template <typename T>
+bool get_varint(const char*& p, const char* end, T& v) {
+	uint64_t ret = 0;
+
+	for (int shift = 0; shift < 64; shift += 7) {
+		if (p == end)
+			return false;
+
+		uint8_t b = *p++;
+		ret |= (uint64_t)(b & 0x7f) << shift;
+
+		if (!(b & 0x80)) {
+			v = (T)ret;
+			return v == ret;
+		}
+	}
+
+	return false;
+}
\ No newline at end of file
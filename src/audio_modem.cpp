@@ -1,6 +1,13 @@
 #include "audio_modem.h"
 #include "fsk.h"
+#include "baud_estimator.h"
+#include "multi_receiver.h"
+#include "interleaver.h"
+#include "fountain.h"
+#include "soft_combiner.h"
+#include "compress.h"
 #include <iostream>
+#include <algorithm>
 
 int audio_modem::callback(const void* inputBuffer, void* outputBuffer,
     unsigned long framesPerBuffer,
@@ -26,7 +33,26 @@ int audio_modem::callback(const void* inputBuffer, void* outputBuffer,
 void audio_modem::demod_callback() {
     std::vector<short> v;
     std::vector<char> received;
-    packet* buff = new packet();
+    std::vector<int8_t> llr;
+    std::vector<char> ready;
+    std::vector<int8_t> ready_llr;
+    frame_assembler assembler(frame_payload());
+    fountain_assembler broadcasts(frame_payload());
+    soft_combiner combiner;
+
+    // Frames come off the air in interleaved groups; a group cut short by a gap is dropped so the next one lines up.
+    interleaver deinterleaver(m_adaptive ? 1 : m_interleave.load());
+    auto group_deadline = std::chrono::steady_clock::now();
+
+    // In adaptive mode the configured device only carries the mode frames; each burst after one is read by its own device.
+    modem_device* burst = NULL;
+    int burst_left = 0;
+    auto burst_deadline = std::chrono::steady_clock::now();
+    auto repair_deadline = std::chrono::steady_clock::now();
+
+    // While a retransmission may still come, frames ride out short fades so their weak soft values can be combined
+    // with it. Interleaved groups already hold on through whole bursts.
+    bool fading = false;
 
     while (demod_flag) {
         buffer->input_buffer.pop(v);
@@ -36,34 +62,338 @@ void audio_modem::demod_callback() {
             continue;
         }
 
-        if (!m_device->is_synchronized()) {
-            int result = m_device->sync(v);
+        modem_device* device = burst ? burst : m_device;
+
+        if (m_adaptive)
+            m_link.measure(v, device->is_synchronized());
+
+        if (!device->is_synchronized()) {
+            device->sync(v);
+
+            if (burst && !burst->is_synchronized() && std::chrono::steady_clock::now() > burst_deadline) {
+                m_link.frame_lost();
+                delete burst;
+                burst = NULL;
+            }
+
+            // Once the channel has gone quiet, ask the senders for whatever is still missing.
+            if (!device->is_synchronized() && std::chrono::steady_clock::now() > repair_deadline) {
+                request_repair(assembler);
+                repair_deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(repair_delay_ms);
+            }
+
+            if (!device->is_synchronized() && deinterleaver.pending() > 0 && std::chrono::steady_clock::now() > group_deadline)
+                deinterleaver.reset();
+
             continue;
         }
 
-        int ret = m_device->demoulate(v, received);
+        int ret = device->demoulate_soft(v, received, llr);
 
-        buff->push(received);
-        
-        if (buff->header())
-            m_signal_sender.packet_receiving(buff->packet_data().size(), buff->header()->len);
+        // A frame cut short still holds its slot in the group, with whatever is missing counted as erased. A false start
+        // dropped before its first byte never had a slot.
+        if (ret == -1 && deinterleaver.group_frames() > 1 && !received.empty() && received.size() % frame_size != 0) {
+            received.resize((received.size() / frame_size + 1) * frame_size, 0);
+            llr.resize(received.size() * 8, 0);
+        }
+
+        while (received.size() >= frame_size) {
+            bool complete = deinterleaver.push(received.data(), llr.size() >= frame_size * 8 ? llr.data() : nullptr);
+
+            received.erase(received.begin(), received.begin() + frame_size);
+            llr.erase(llr.begin(), llr.begin() + std::min(llr.size(), (size_t)frame_size * 8));
+            group_deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(group_timeout_ms);
 
-        if (buff->finished()) {
-            m_packet_queue.push(buff);
-            buff = new packet();
-            m_signal_sender.packet_received();
+            if (complete)
+                deinterleaver.pop(ready, ready_llr);
         }
 
-        if (ret == -1) {
-            if (buff->header())
+        while (ready.size() >= frame_size) {
+            std::vector<char>& frame = m_frame;
+            frame.assign(ready.begin(), ready.begin() + frame_size);
+
+            // The bit reliabilities let the decoder weigh each bit instead of trusting every decision equally.
+            bool intact = m_fec != fec_scheme::none ? repair_frame(frame.data(), ready_llr.data(), m_fec) : frame_intact(frame.data());
+
+            // A failed frame is kept soft, and its retransmission is decoded together with it.
+            if (!intact)
+                intact = combiner.combine(frame.data(), ready_llr.data(), m_fec);
+
+            ready.erase(ready.begin(), ready.begin() + frame_size);
+            ready_llr.erase(ready_llr.begin(), ready_llr.begin() + frame_size * 8);
+            mode_header mode;
+
+            if (intact)
+                repair_deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(repair_delay_ms);
+
+            if (intact && m_adaptive && parse_mode_frame(frame.data(), mode)) {
+                m_link.feedback(mode.report);
+
+                delete burst;
+                burst = modem_device::new_device((modem_type)mode.device_type, m_sample_rate, mode.baud_rate);
+                burst_left = mode.frames;
+                burst_deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(burst_timeout_ms);
+
+                continue;
+            }
+
+            if (m_adaptive) {
+                if (intact)
+                    m_link.frame_received();
+
+                else
+                    m_link.frame_lost();
+            }
+
+            if (burst) {
+                burst_deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(burst_timeout_ms);
+
+                if (--burst_left == 0) {
+                    delete burst;
+                    burst = NULL;
+                }
+            }
+
+            // A damaged frame is simply left out; the packet waits for it to be sent again.
+            if (!intact)
+                continue;
+
+            uint8_t id;
+            uint16_t from;
+            std::vector<uint16_t> seqs;
+
+            if (parse_nack_frame(frame.data(), id, seqs, from, frame_payload())) {
+                resend(id, seqs, from);
+                continue;
+            }
+
+            bool rateless = ((frame_header*)frame.data())->type == (uint8_t)frame_type::fountain;
+            packet* p = rateless ? broadcasts.push(frame.data()) : assembler.push(frame.data());
+            size_t got, length;
+
+            if (p && (!p->valid() || !expand_packet(*p))) {
+                delete p;
                 m_signal_sender.packet_lost();
+            }
+
+            else if (p) {
+                m_packet_queue.push(p);
+                m_signal_sender.packet_received();
+            }
+
+            else if (rateless ? broadcasts.progress(got, length) : assembler.progress(got, length))
+                m_signal_sender.packet_receiving(got, length);
+        }
+
+        bool expecting = !m_adaptive && m_interleave <= 1 && (!combiner.empty() || !assembler.incomplete().empty());
+
+        if (expecting != fading) {
+            m_device->set_burst_tolerance(expecting ? fade_symbols : 0);
+            fading = expecting;
+        }
+
+        if (ret == -1) {
+            if (received.size() >= frame_header_size && m_adaptive)
+                m_link.frame_lost();
+
+            if (burst && device == burst) {
+                delete burst;
+                burst = NULL;
+            }
 
-            buff->clear();
             received.clear();
+            llr.clear();
         }
     }
 
-    delete buff;
+    if (fading)
+        m_device->set_burst_tolerance(0);
+
+    delete burst;
+}
+
+void audio_modem::request_repair(frame_assembler& assembler) {
+    std::vector<uint16_t> seqs;
+    uint16_t from;
+
+    for (uint8_t id : assembler.incomplete()) {
+        if (!assembler.missing(id, seqs, from)) {
+            m_signal_sender.packet_lost();
+            continue;
+        }
+
+        std::vector<char> frame;
+        build_nack_frame(id, seqs, from, frame, frame_payload());
+
+        tx_mtx.lock();
+        m_scheduler.push_frame(std::move(frame), tx_priority::control);
+        tx_mtx.unlock();
+    }
+
+    tx_cv.notify_one();
+}
+
+// Ids count up so that packets sent close together never share one, and an id whose packet may still be asked for
+// again is passed over. Called with tx_mtx held.
+uint8_t audio_modem::allocate_id() {
+    auto taken = [this](uint8_t id) {
+        return std::any_of(m_sent.begin(), m_sent.end(), [id](const std::vector<char>& data) { return ((packet_header*)data.data())->id == id; });
+    };
+
+    while (taken(m_next_id))
+        ++m_next_id;
+
+    return m_next_id++;
+}
+
+void audio_modem::resend(uint8_t id, const std::vector<uint16_t>& seqs, uint16_t from) {
+    std::lock_guard<std::mutex> lock(tx_mtx);
+
+    for (auto& data : m_sent) {
+        if (((packet_header*)data.data())->id != id)
+            continue;
+
+        size_t count = frame_count(data.size(), frame_payload());
+        std::vector<uint16_t> list = seqs;
+
+        // A request naming frames this packet does not have is about some other station's packet with the same id.
+        if ((from != no_seq && from > count) || std::any_of(seqs.begin(), seqs.end(), [count](uint16_t seq) { return seq >= count; }))
+            return;
+
+        for (size_t seq = from; seq < count; ++seq)
+            list.push_back((uint16_t)seq);
+
+        m_scheduler.resend(data, std::move(list), tx_priority::control, frame_payload());
+        tx_cv.notify_one();
+
+        return;
+    }
+}
+
+void audio_modem::protect(std::vector<char>& frames) {
+    if (m_fec == fec_scheme::none)
+        return;
+
+    for (size_t i = 0; i + frame_size <= frames.size(); i += frame_size)
+        protect_frame(frames.data() + i, m_fec);
+}
+
+void audio_modem::interleave(std::vector<char>& frames) {
+    if (m_interleave <= 1)
+        return;
+
+    interleaver block(m_interleave);
+    std::vector<char> group(block.group_frames() * frame_size);
+
+    for (size_t i = 0; i + group.size() <= frames.size(); i += group.size()) {
+        block.interleave(frames.data() + i, group.data());
+        std::copy(group.begin(), group.end(), frames.begin() + i);
+    }
+}
+
+void audio_modem::tx_callback() {
+    std::vector<std::function<void(bool)>> finished;
+
+    while (true) {
+        // Completions of played audio are fired here rather than in the audio callback, and with no lock held,
+        // since a callback may well submit the next packet.
+        for (auto& done : finished)
+            done(true);
+
+        finished.clear();
+
+        {
+            std::unique_lock<std::mutex> lock(tx_mtx);
+            tx_cv.wait_for(lock, std::chrono::milliseconds(10), [this]() { return !tx_flag || !m_scheduler.empty(); });
+
+            if (!tx_flag)
+                break;
+
+            if (!audio_stream_operating() && !m_scheduler.empty()) {
+                tx_scheduler dropped = std::move(m_scheduler);
+                m_scheduler = tx_scheduler();
+
+                lock.unlock();
+                dropped.clear();
+
+                continue;
+            }
+        }
+
+        std::shared_ptr<io_buffer> out;
+
+        {
+            std::lock_guard<std::mutex> device_lock(device_mtx);
+            out = buffer;
+        }
+
+        out->output_buffer.complete(finished);
+
+        // Playback frees room in its own time; wait for it without a lock, so submit and resend never queue behind it.
+        if (!out->output_buffer.wait(tx_lookahead, std::chrono::milliseconds(10)))
+            continue;
+
+        std::lock_guard<std::mutex> device_lock(device_mtx);
+
+        modem_device* device = m_device;
+        std::vector<char> frames;
+        std::vector<short> modulated;
+        std::vector<std::function<void(bool)>> callbacks;
+
+        if (m_adaptive) {
+            link_mode mode = m_link.mode();
+
+            if (!m_tx_device || m_tx_device->type() != mode.type || m_tx_device->baud_rate() != mode.baud_rate) {
+                delete m_tx_device;
+                m_tx_device = modem_device::new_device(mode.type, m_sample_rate, mode.baud_rate);
+            }
+
+            device = m_tx_device;
+        }
+
+        int count = device->frame_length() / frame_size * (m_adaptive ? adaptive_burst : 1);
+        int group = m_adaptive ? 1 : m_interleave.load();
+
+        // Interleaved groups always go out whole, topped up with fill frames, so the receiver can count them off.
+        count = (count + group - 1) / group * group;
+
+        tx_mtx.lock();
+
+        for (int i = 0; i < count && !m_scheduler.empty(); ++i) {
+            std::function<void(bool)> callback;
+            m_scheduler.pop(frames, callback);
+
+            if (callback)
+                callbacks.push_back(std::move(callback));
+        }
+
+        tx_mtx.unlock();
+
+        if (frames.empty())
+            continue;
+
+        while (frames.size() / frame_size % group != 0)
+            build_fill_frame(frames);
+
+        // Announce the burst in the configured mode, with our view of the peer's signal riding along for its own rate choice.
+        if (m_adaptive) {
+            std::vector<char> control;
+            build_mode_frame(mode_header(device->type(), device->baud_rate(), (int)(frames.size() / frame_size), m_link.report()), control);
+            protect(control);
+            m_device->modulate(control, modulated);
+        }
+
+        protect(frames);
+
+        if (!m_adaptive)
+            interleave(frames);
+
+        device->modulate(frames, modulated);
+        out->output_buffer.push(std::move(modulated), [callbacks](bool played) {
+            for (auto& callback : callbacks)
+                callback(played);
+        });
+    }
 }
 
 audio_modem::audio_modem(int chunk_size, int sample_rate, modem_device* device) {
@@ -72,25 +402,44 @@ audio_modem::audio_modem(int chunk_size, int sample_rate, modem_device* device)
     if (!device)
         device = new fsk(sample_rate, 1225);
 
-    buffer = new io_buffer(chunk_size);
+    buffer = std::make_shared<io_buffer>(chunk_size);
 
     this->m_chunk_size = chunk_size;
     this->m_sample_rate = sample_rate;
     this->m_device = device;
+    this->m_tx_device = NULL;
+    this->m_adaptive = false;
+    this->m_detect_baud = false;
+    this->m_fec = fec_scheme::none;
+    this->m_interleave = 1;
+    this->m_compress = false;
+    this->m_next_id = 0;
     this->stream = NULL;
 
     this->m_input_device = Pa_GetDefaultInputDevice();
     this->m_output_device = Pa_GetDefaultOutputDevice();
+
+    tx_flag = true;
+    tx_thread = std::thread(&audio_modem::tx_callback, this);
 }
 
 audio_modem::~audio_modem() {
+    tx_mtx.lock();
+    tx_flag = false;
+    tx_mtx.unlock();
+
+    tx_cv.notify_all();
+    tx_thread.join();
+    m_scheduler.clear();
+
     stop_stream();
     stop_demodulate();
 
     if (m_device)
         delete m_device;
 
-    delete buffer;
+    delete m_tx_device;
+
 
     Pa_Terminate();
 }
@@ -112,23 +461,23 @@ bool audio_modem::start_stream() {
     PaStreamParameters o_params { m_output_device, 1, paInt16, o_device_info->defaultLowOutputLatency, NULL };
     
     PaError result;
+    PaStream* opened = NULL;
 
-    result = Pa_OpenStream(&stream, &i_params, &o_params, m_sample_rate, m_chunk_size, paNoFlag, &callback, buffer);
+    result = Pa_OpenStream(&opened, &i_params, &o_params, m_sample_rate, m_chunk_size, paNoFlag, &callback, buffer.get());
 
-    if (result != paNoError) {
-        stream = NULL;
+    if (result != paNoError)
         return false;
-    }
 
-    result = Pa_StartStream(stream);
+    result = Pa_StartStream(opened);
 
     if (result != paNoError) {
-        Pa_CloseStream(stream);
-        stream = NULL;
-
+        Pa_CloseStream(opened);
         return false;
     }
 
+    // The TX thread polls this without taking device_mtx, so it is published only once the stream runs.
+    stream = opened;
+
     return true;
 }
 
@@ -136,10 +485,11 @@ bool audio_modem::stop_stream() {
     if (stream == NULL)
         return false;
 
-    Pa_StopStream(stream);
-    Pa_CloseStream(stream);
+    PaStream* closing = stream.exchange(NULL);
+
+    Pa_StopStream(closing);
+    Pa_CloseStream(closing);
 
-    stream = NULL;
     buffer->input_buffer.clear();
     buffer->output_buffer.clear();
 
@@ -168,9 +518,22 @@ bool audio_modem::stop_demodulate() {
 }
 
 void audio_modem::modulate(char* src, size_t size) {
+    if (size < header_size)
+        return;
+
+    std::vector<char> data(src, src + size), frames;
     std::vector<short> modulated;
 
-    m_device->modulate(src, size, modulated);
+    packet::seal(data);
+
+    for (size_t seq = 0; seq < frame_count(size, frame_payload()); ++seq)
+        build_frame(data, (uint16_t)seq, frames, frame_payload());
+
+    protect(frames);
+
+    std::lock_guard<std::mutex> lock(device_mtx);
+
+    m_device->modulate(frames, modulated);
     buffer->output_buffer.push(std::move(modulated));
 }
 
@@ -178,6 +541,76 @@ void audio_modem::modulate(std::vector<char>& src) {
     modulate(src.data(), src.size());
 }
 
+std::future<bool> audio_modem::submit(std::vector<char> src, tx_priority priority) {
+    auto promise = std::make_shared<std::promise<bool>>();
+    std::future<bool> ret = promise->get_future();
+
+    submit(std::move(src), priority, [promise](bool played) { promise->set_value(played); });
+
+    return ret;
+}
+
+void audio_modem::submit(std::vector<char> src, tx_priority priority, std::function<void(bool)> callback) {
+    if (src.size() < header_size) {
+        if (callback)
+            callback(false);
+
+        return;
+    }
+
+    tx_mtx.lock();
+    ((packet_header*)src.data())->id = allocate_id();
+    tx_mtx.unlock();
+
+    // Callers fill in the header after building the packet, so the checks are only final here.
+    if (m_compress)
+        compress_packet(src);
+
+    packet::seal(src);
+
+    tx_mtx.lock();
+
+    // Keep a copy of recent packets so frames the receiver missed can be sent again.
+    m_sent.push_back(src);
+
+    if (m_sent.size() > max_sent)
+        m_sent.pop_front();
+
+    m_scheduler.push(std::move(src), priority, std::move(callback), frame_payload());
+
+    tx_mtx.unlock();
+    tx_cv.notify_one();
+}
+
+// Broadcasts carry no repair requests. The packet goes out as an endless run of fountain frames, any set of which
+// slightly larger than the packet rebuilds it, until stop_broadcast.
+void audio_modem::broadcast(std::vector<char> src) {
+    if (src.size() < header_size || src.size() > max_packet_size)
+        return;
+
+    tx_mtx.lock();
+    ((packet_header*)src.data())->id = allocate_id();
+    tx_mtx.unlock();
+
+    if (m_compress)
+        compress_packet(src);
+
+    packet::seal(src);
+
+    auto encoder = std::make_shared<fountain_encoder>(src, frame_payload());
+    uint32_t index = 0;
+
+    tx_mtx.lock();
+    m_scheduler.push_stream([encoder, index](std::vector<char>& frame) mutable { encoder->build_frame(index++, frame); }, tx_priority::bulk);
+    tx_mtx.unlock();
+    tx_cv.notify_one();
+}
+
+void audio_modem::stop_broadcast() {
+    std::lock_guard<std::mutex> lock(tx_mtx);
+    m_scheduler.end_streams();
+}
+
 void audio_modem::set_chunk_size(int chunk_size) {
     stop_demodulate();
     stop_stream();
@@ -189,10 +622,13 @@ void audio_modem::set_sample_rate(int sample_rate) {
     stop_demodulate();
     stop_stream();
 
+    std::lock_guard<std::mutex> lock(device_mtx);
     modem_device* tmp = m_device->new_device(sample_rate, m_device->baud_rate());
     delete this->m_device;
+    delete this->m_tx_device;
 
     this->m_device = tmp;
+    this->m_tx_device = NULL;
     this->m_sample_rate = sample_rate;
 }
 
@@ -203,6 +639,7 @@ void audio_modem::set_modem_device(modem_device* device) {
     stop_demodulate();
     stop_stream();
 
+    std::lock_guard<std::mutex> lock(device_mtx);
     delete this->m_device;
     this->m_device = device;
 }
@@ -263,31 +700,47 @@ modem_config audio_modem::config() {
         m_device->baud_rate(),
         m_device->type(),
         input_volume,
-        output_volume
+        output_volume,
+        m_adaptive,
+        m_detect_baud,
+        m_fec,
+        m_interleave,
+        m_compress
     };
 }
 
 void audio_modem::set_config(const modem_config& config) {
     set_volume(config.input_volume, config.output_volume);
 
+    // AUTO passes on frames from whichever lane locks and drops partial ones, so it cannot count frames off into groups.
+    int depth = config.device_type == modem_type::auto_rx ? 1 : std::min(std::max(config.interleave, 1), interleaver::max_depth);
+
+    // Receivers expand whatever arrives flagged, so this only affects what we send and needs no restart.
+    m_compress = config.compress;
+
     if (
         m_input_device == config.input_device &&
         m_output_device == config.output_device &&
         m_chunk_size == config.chunk_size &&
         m_sample_rate == config.sample_rate &&
         m_device->baud_rate() == config.baud_rate &&
-        m_device->type() == config.device_type) 
+        m_device->type() == config.device_type &&
+        m_adaptive == config.adaptive &&
+        m_detect_baud == config.detect_baud &&
+        m_fec == config.fec &&
+        m_interleave == depth) 
     {
         return;
     }
 
     stop_demodulate();
     stop_stream();
-     
+
+    std::lock_guard<std::mutex> lock(device_mtx);
+
     if (m_chunk_size != config.chunk_size) {
         m_chunk_size = config.chunk_size;
-        delete buffer;
-        buffer = new io_buffer(m_chunk_size);
+        buffer = std::make_shared<io_buffer>(m_chunk_size);
     }
 
     m_input_device = config.input_device;
@@ -295,6 +748,26 @@ void audio_modem::set_config(const modem_config& config) {
     m_sample_rate = config.sample_rate;
 
     delete m_device;
+    delete m_tx_device;
     m_device = modem_device::new_device(config.device_type, m_sample_rate, config.baud_rate);
+
+    // AUTO checks frames itself to tell which of its lanes has the right modem, so it needs to know the code.
+    if (config.device_type == modem_type::auto_rx)
+        static_cast<multi_receiver*>(m_device)->set_fec(config.fec);
+
+    // Only devices with a known preamble tone can be measured; the rest keep the configured baud.
+    if (config.detect_baud && m_device->preamble_tone() > 0)
+        m_device = new baud_estimator(m_device);
+
+    // Adaptive bursts are not interleaved, so only a fixed device needs to hold on through a burst.
+    if (!config.adaptive && depth > 1)
+        m_device->set_burst_tolerance(burst_symbols);
+
+    m_tx_device = NULL;
+    m_adaptive = config.adaptive;
+    m_detect_baud = config.detect_baud;
+    m_fec = config.fec;
+    m_interleave = depth;
+    m_link.reset();
     m_signal_sender.configuration_changed();
 }
\ No newline at end of file
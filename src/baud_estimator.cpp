@@ -0,0 +1,224 @@
+#include "baud_estimator.h"
+#include <cmath>
+#include <algorithm>
+
+baud_estimator::baud_estimator(modem_device* prototype) : modem_device(prototype->sample_rate(), prototype->baud_rate()),
+	prototype(prototype), device(NULL), transform(4096)
+{
+	noise_floor = inf;
+	onset_found = false;
+	m_tone = 0;
+	idle = 0;
+	tolerance = 0;
+}
+
+baud_estimator::~baud_estimator() {
+	delete device;
+	delete prototype;
+}
+
+double baud_estimator::measure(std::vector<short>& v, size_t start, size_t len, double& purity) {
+	len = std::min({ len, v.size() - start, (size_t)transform.size() });
+
+	double mean = 0;
+
+	for (size_t i = 0; i < len; ++i)
+		mean += v[start + i];
+
+	mean /= len;
+
+	re.assign(transform.size(), 0);
+	im.assign(transform.size(), 0);
+
+	double sum = 0, sum_sq = 0, energy = 0;
+
+	// A Hann window keeps the mirror image of a short tone from pulling the peak.
+	for (size_t i = 0; i < len; ++i) {
+		double w = 0.5 - 0.5 * std::cos(2 * pi * i / len);
+		re[i] = (v[start + i] - mean) * w;
+
+		sum += w;
+		sum_sq += w * w;
+		energy += re[i] * re[i];
+	}
+
+	transform.forward(re, im);
+
+	int n = transform.size();
+	int lo = std::max(2, (int)(100.0 * n / m_sample_rate));
+	int hi = std::min(n / 2 - 2, (int)(0.45 * n));
+	int peak = lo;
+
+	for (int k = lo; k <= hi; ++k) {
+		if (re[k] * re[k] + im[k] * im[k] > re[peak] * re[peak] + im[peak] * im[peak])
+			peak = k;
+	}
+
+	double a = std::hypot(re[peak - 1], im[peak - 1]);
+	double b = std::hypot(re[peak], im[peak]);
+	double c = std::hypot(re[peak + 1], im[peak + 1]);
+	double denom = a - 2 * b + c;
+	double offset = denom != 0 ? 0.5 * (a - c) / denom : 0;
+
+	// Share of the window's energy that sits in the peak: close to 1 for a clean tone, small for noise.
+	purity = energy > 0 ? 2 * sum_sq * b * b / (energy * sum * sum) : 0;
+
+	return (peak + offset) * m_sample_rate / n;
+}
+
+double baud_estimator::energy(std::vector<short>& v, size_t start, size_t len) {
+	double sum = 0;
+
+	for (size_t i = start; i < start + len; ++i)
+		sum += (double)v[i] * v[i];
+
+	return sum / len;
+}
+
+double baud_estimator::estimate(std::vector<short>& v) {
+	if (!onset_found) {
+		size_t blocks = v.size() / block;
+		double quietest = inf;
+
+		for (size_t k = 0; k < blocks; ++k)
+			quietest = std::min(quietest, energy(v, k * block, block));
+
+		// Let the floor rise slowly so a receiver that starts mid-transmission still finds the next onset.
+		noise_floor = std::min(quietest, noise_floor * 1.1);
+
+		double level = std::max(noise_floor * onset_ratio, min_level * min_level * 32767.0 * 32767.0);
+		size_t onset = v.size();
+		double signal = 0;
+
+		// A single loud block may be noise; the transmission has to stay up for a few blocks.
+		for (size_t k = 0; k + confirm_blocks <= blocks; ++k) {
+			if (energy(v, k * block, block) > level && (signal = energy(v, k * block, confirm_blocks * block)) > level) {
+				onset = k * block;
+				break;
+			}
+		}
+
+		if (onset == v.size()) {
+			v.erase(v.begin(), v.begin() + (v.size() - std::min(v.size(), (size_t)(confirm_blocks * block))));
+			return 0;
+		}
+
+		// Long blocks keep noise from triggering; short ones then find where the tone actually starts.
+		double edge = std::max(level, std::sqrt(noise_floor * signal));
+		size_t from = onset - std::min(onset, (size_t)block);
+
+		for (size_t i = from; i < onset + block; i += fine_block) {
+			if (energy(v, i, fine_block) > edge) {
+				onset = i;
+				break;
+			}
+		}
+
+		v.erase(v.begin(), v.begin() + onset);
+		onset_found = true;
+	}
+
+	if (v.size() < min_samples)
+		return 0;
+
+	onset_found = false;
+
+	// Every frame opens with a run of identical symbols, each one carrier cycle long. Start from a window shorter
+	// than the fastest preamble, then widen to five cycles so the estimate sharpens without reaching the marker.
+	double purity;
+	double tone = measure(v, 0, first_window, purity);
+
+	for (int pass = 0; pass < 2 && tone > 0; ++pass)
+		tone = measure(v, 0, (size_t)(5 * m_sample_rate / tone), purity);
+
+	// Noise that happened to cross the onset level has no clear tone, so look past it.
+	if (purity < min_purity) {
+		v.erase(v.begin(), v.begin() + block);
+		return 0;
+	}
+
+	return tone;
+}
+
+int baud_estimator::match_baud(double tone) {
+	int guess = (int)std::round(tone);
+	modem_device* probe = prototype->new_device(m_sample_rate, guess);
+	double ratio = probe->preamble_tone() / guess;
+	delete probe;
+
+	if (ratio <= 0)
+		return 0;
+
+	// Symbol lengths are whole samples, so a tone maps to a small range of bauds; try a few and keep the closest.
+	int ret = 0;
+	double min_error = max_tone_error;
+
+	for (int j = -4; j <= 4; ++j) {
+		int baud = (int)std::round(tone / ratio * (1 + 0.005 * j));
+		modem_device* candidate = prototype->new_device(m_sample_rate, baud);
+		double error = std::abs(candidate->preamble_tone() - tone) / tone;
+		delete candidate;
+
+		if (error < min_error) {
+			min_error = error;
+			ret = baud;
+		}
+	}
+
+	return ret;
+}
+
+int baud_estimator::sync(std::vector<short>& v) {
+	if (!device) {
+		double tone = estimate(v);
+
+		if (tone <= 0)
+			return -1;
+
+		int baud = match_baud(tone);
+
+		m_tone = tone;
+		device = prototype->new_device(m_sample_rate, baud > 0 ? baud : m_baud_rate);
+		device->set_burst_tolerance(tolerance);
+		idle = 0;
+	}
+
+	int ret = device->sync(v);
+	synchronized = device->is_synchronized();
+
+	// Once the sender goes quiet, measure the next transmission afresh.
+	if (synchronized)
+		idle = 0;
+
+	else if (++idle > max_idle) {
+		delete device;
+		device = NULL;
+	}
+
+	return ret;
+}
+
+int baud_estimator::demoulate(std::vector<short>& v, std::vector<char>& dst) {
+	int ret = device->demoulate(v, dst);
+	synchronized = device->is_synchronized();
+
+	return ret;
+}
+
+int baud_estimator::demoulate_soft(std::vector<short>& v, std::vector<char>& dst, std::vector<int8_t>& llr) {
+	int ret = device->demoulate_soft(v, dst, llr);
+	synchronized = device->is_synchronized();
+
+	return ret;
+}
+
+void baud_estimator::set_burst_tolerance(int symbols) {
+	tolerance = symbols;
+
+	if (device)
+		device->set_burst_tolerance(symbols);
+}
+
+void baud_estimator::modulate(char* src, size_t size, std::vector<short>& dst) {
+	prototype->modulate(src, size, dst);
+}
\ No newline at end of file
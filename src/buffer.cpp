@@ -85,51 +85,109 @@ bool array_buffer::empty() {
 	bool ret;
 
 	m.lock();
-	ret = (queue.size() == 0);
+	ret = (queue.size() == played);
 	m.unlock();
 
 	return ret;
 }
 
-void array_buffer::push(std::vector<data_type>&& src) {
+size_t array_buffer::size() {
+	size_t ret;
+
+	m.lock();
+	ret = queue.size() - played;
+	m.unlock();
+
+	return ret;
+}
+
+void array_buffer::push(std::vector<data_type>&& src, std::function<void(bool)> done) {
 	int pad = chunk_size - (src.size() % chunk_size);
 	pad = pad % chunk_size;
 
 	src.insert(src.end(), pad, 0);
-	src.push_back(0);
+
+	if (src.size() == 0) {
+		if (done)
+			done(true);
+
+		return;
+	}
 
 	m.lock();
 
-	queue.push_back(std::move(src));
+	queue.push_back(entry{ std::move(src), 0, std::move(done) });
 
 	m.unlock();
 }
 
+// Runs in the audio callback, so it only copies samples; finished entries wait for complete().
 void array_buffer::pop(void* dst) {
+	bool finished = false;
+
 	m.lock();
 
-	if (queue.size() == 0) {
+	if (queue.size() == played) {
 		m.unlock();
 		return;
 	}
 
-	std::vector<data_type>& data = queue[0];
-	size_t idx = data[data.size() - 1];
+	entry& e = queue[played];
+
+	std::copy(e.samples.begin() + e.offset, e.samples.begin() + e.offset + chunk_size, (data_type*)dst);
+	e.offset += chunk_size;
+
+	if (e.offset >= e.samples.size()) {
+		played += 1;
+		finished = true;
+	}
+
+	m.unlock();
+
+	if (finished)
+		drained.notify_all();
+}
+
+// Waits until fewer than limit entries are left to play; false if the timeout passes first.
+bool array_buffer::wait(size_t limit, std::chrono::milliseconds timeout) {
+	std::unique_lock<std::mutex> lock(m);
+
+	return drained.wait_for(lock, timeout, [&]() { return queue.size() - played < limit; });
+}
 
-	std::copy(data.begin() + idx * chunk_size, data.begin() + ((idx + 1) * chunk_size), (data_type*)dst);
+// Takes the played entries off the queue and hands back their completions for the caller to fire.
+void array_buffer::complete(std::vector<std::function<void(bool)>>& done) {
+	std::deque<entry> finished;
 
-	data[data.size() - 1] += 1;
+	m.lock();
 
-	if ((idx + 1) * chunk_size >= data.size() - 1)
-		queue.erase(queue.begin());
+	finished.insert(finished.end(), std::make_move_iterator(queue.begin()), std::make_move_iterator(queue.begin() + played));
+	queue.erase(queue.begin(), queue.begin() + played);
+	played = 0;
 
 	m.unlock();
+
+	for (auto& e : finished) {
+		if (e.done)
+			done.push_back(std::move(e.done));
+	}
 }
 
 void array_buffer::clear() {
+	std::deque<entry> dropped;
+	size_t finished;
+
 	m.lock();
 
-	queue.clear();
+	dropped.swap(queue);
+	finished = played;
+	played = 0;
 
 	m.unlock();
+	drained.notify_all();
+
+	for (size_t i = 0; i < dropped.size(); ++i) {
+		if (dropped[i].done)
+			dropped[i].done(i < finished);
+	}
 }
\ No newline at end of file
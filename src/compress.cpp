@@ -0,0 +1,263 @@
+#include "compress.h"
+#include "text_dictionary.h"
+#include "varint.h"
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+
+static constexpr size_t min_match = 4;
+static constexpr int max_probes = 16;
+static constexpr size_t max_offset = UINT16_MAX;
+static constexpr int hash_bits = 12;
+
+static uint32_t read32(const char* p) {
+	uint32_t ret;
+	memcpy(&ret, p, sizeof(ret));
+
+	return ret;
+}
+
+static void put_length(size_t len, std::vector<char>& dst) {
+	for (; len >= 255; len -= 255)
+		dst.push_back((char)255);
+
+	dst.push_back((char)len);
+}
+
+static void put_sequence(const char* literals, size_t count, size_t offset, size_t match, std::vector<char>& dst) {
+	size_t extra = match >= min_match ? match - min_match : 0;
+	dst.push_back((char)((std::min(count, (size_t)15) << 4) | (match ? std::min(extra, (size_t)15) : 0)));
+
+	if (count >= 15)
+		put_length(count - 15, dst);
+
+	dst.insert(dst.end(), literals, literals + count);
+
+	if (!match)
+		return;
+
+	dst.push_back((char)(offset & 0xff));
+	dst.push_back((char)(offset >> 8));
+
+	if (extra >= 15)
+		put_length(extra - 15, dst);
+}
+
+void lz_compress(const char* src, size_t size, std::vector<char>& dst, const char* dict, size_t dict_size) {
+	// Work over the dictionary and the input as one buffer, so offsets into the dictionary need no special case.
+	std::vector<char> buffer;
+	const char* base = src;
+	size_t start = 0;
+
+	// Only the last 64 KB of a dictionary are in reach of an offset.
+	if (dict && dict_size > max_offset) {
+		dict += dict_size - max_offset;
+		dict_size = max_offset;
+	}
+
+	if (dict && dict_size > 0) {
+		buffer.reserve(dict_size + size);
+		buffer.insert(buffer.end(), dict, dict + dict_size);
+		buffer.insert(buffer.end(), src, src + size);
+		base = buffer.data();
+		start = dict_size;
+	}
+
+	size_t end = start + size;
+	std::vector<int32_t> table((size_t)1 << hash_bits, -1), chain(end, -1);
+	auto hash = [](uint32_t v) { return (v * 2654435761u) >> (32 - hash_bits); };
+
+	auto insert = [&](size_t i) {
+		uint32_t h = hash(read32(base + i));
+		chain[i] = table[h];
+		table[h] = (int32_t)i;
+	};
+
+	for (size_t i = 0; i + min_match <= start; ++i)
+		insert(i);
+
+	size_t pos = start, anchor = start;
+
+	while (pos + min_match <= end) {
+		uint32_t seq = read32(base + pos);
+		size_t best = 0, offset = 0;
+		int probes = 0;
+
+		// Walk the positions sharing this hash, newest first, and keep the longest match.
+		for (int32_t candidate = table[hash(seq)]; candidate >= 0 && probes < max_probes; candidate = chain[candidate], ++probes) {
+			if (pos - (size_t)candidate > max_offset)
+				break;
+
+			if (read32(base + candidate) != seq)
+				continue;
+
+			size_t len = min_match;
+
+			while (pos + len < end && base[candidate + len] == base[pos + len])
+				len += 1;
+
+			if (len > best) {
+				best = len;
+				offset = pos - candidate;
+			}
+		}
+
+		insert(pos);
+
+		if (!best) {
+			pos += 1;
+			continue;
+		}
+
+		put_sequence(base + anchor, pos - anchor, offset, best, dst);
+
+		for (size_t i = pos + 1; i < pos + best && i + min_match <= end; ++i)
+			insert(i);
+
+		pos += best;
+		anchor = pos;
+	}
+
+	put_sequence(base + anchor, end - anchor, 0, 0, dst);
+}
+
+bool lz_decompress(const char* src, size_t size, std::vector<char>& dst, size_t max_size, const char* dict, size_t dict_size) {
+	const uint8_t* in = (const uint8_t*)src;
+	const uint8_t* in_end = in + size;
+	std::vector<char> out;
+
+	if (!dict)
+		dict_size = 0;
+
+	if (dict_size > max_offset) {
+		dict += dict_size - max_offset;
+		dict_size = max_offset;
+	}
+
+	out.reserve(dict_size + max_size);
+	out.insert(out.end(), dict, dict + dict_size);
+
+	auto get_length = [&](size_t& len) {
+		uint8_t b;
+
+		do {
+			if (in == in_end)
+				return false;
+
+			b = *in++;
+			len += b;
+		} while (b == 255);
+
+		return true;
+	};
+
+	while (in < in_end) {
+		uint8_t token = *in++;
+		size_t count = token >> 4;
+
+		if (count == 15 && !get_length(count))
+			return false;
+
+		if (count > (size_t)(in_end - in) || out.size() + count > dict_size + max_size)
+			return false;
+
+		out.insert(out.end(), in, in + count);
+		in += count;
+
+		// The block ends on literals.
+		if (in == in_end)
+			break;
+
+		if (in_end - in < 2)
+			return false;
+
+		size_t offset = in[0] | in[1] << 8;
+		size_t len = token & 15;
+		in += 2;
+
+		if (len == 15 && !get_length(len))
+			return false;
+
+		len += min_match;
+
+		if (offset == 0 || offset > out.size() || out.size() + len > dict_size + max_size)
+			return false;
+
+		// Matches may overlap what they write, so copy byte by byte.
+		size_t from = out.size() - offset;
+
+		for (size_t i = 0; i < len; ++i)
+			out.push_back(out[from + i]);
+	}
+
+	dst.insert(dst.end(), out.begin() + dict_size, out.end());
+	return true;
+}
+
+// Text packets are compressed against the shared dictionary; both ends know which packets are text.
+static void dictionary(const std::vector<char>& data, const char*& dict, size_t& dict_size) {
+	bool text = (((const packet_header*)data.data())->control & ~packet_control::compressed) == packet_control::text;
+
+	dict = text ? text_dictionary : nullptr;
+	dict_size = text ? text_dictionary_size : 0;
+}
+
+bool compress_packet(std::vector<char>& data) {
+	if (data.size() <= header_size)
+		return false;
+
+	// The body carries its raw length first as a varint, so the receiver knows how much to expect.
+	size_t raw = data.size() - header_size;
+	std::vector<char> body;
+	const char* dict;
+	size_t dict_size;
+
+	put_varint(raw, body);
+	dictionary(data, dict, dict_size);
+	lz_compress(data.data() + header_size, raw, body, dict, dict_size);
+
+	if (body.size() >= raw)
+		return false;
+
+	data.resize(header_size);
+	data.insert(data.end(), body.begin(), body.end());
+
+	packet_header* header = (packet_header*)data.data();
+	header->control |= packet_control::compressed;
+	header->len = (uint16_t)data.size();
+
+	return true;
+}
+
+bool expand_packet(packet& p) {
+	packet_header* header = p.header();
+
+	if (!header || !(header->control & packet_control::compressed))
+		return true;
+
+	std::vector<char>& data = p.packet_data();
+	const char* src = data.data() + header_size;
+	const char* end = data.data() + data.size();
+	size_t raw;
+	const char* dict;
+	size_t dict_size;
+
+	if (!get_varint(src, end, raw) || raw > max_data_size)
+		return false;
+
+	std::vector<char> body;
+	dictionary(data, dict, dict_size);
+
+	if (!lz_decompress(src, end - src, body, raw, dict, dict_size) || body.size() != raw)
+		return false;
+
+	data.resize(header_size);
+	data.insert(data.end(), body.begin(), body.end());
+
+	header = p.header();
+	header->control &= ~packet_control::compressed;
+	header->len = (uint16_t)data.size();
+	packet::seal(data);
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,101 @@
+#include "convolutional.h"
+#include <bitset>
+#include <emmintrin.h>
+
+convolutional_code::convolutional_code() {
+	// Old states j and j + 32 differ only in the oldest bit, which both generators tap, so one butterfly shares a
+	// branch label and its complement. Store the label of j taking a 0 as a negation mask per output bit.
+	for (int j = 0; j < 32; ++j) {
+		sign0[j] = parity((j << 1) & poly0) ? -1 : 0;
+		sign1[j] = parity((j << 1) & poly1) ? -1 : 0;
+	}
+}
+
+int convolutional_code::parity(int x) {
+	return std::bitset<8>(x).count() & 1;
+}
+
+void convolutional_code::encode(const char* src, size_t size, std::vector<uint8_t>& dst) {
+	int state = 0;
+
+	auto push = [&](int bit) {
+		int reg = (state << 1) | bit;
+
+		dst.push_back(parity(reg & poly0));
+		dst.push_back(parity(reg & poly1));
+		state = reg & 63;
+	};
+
+	for (size_t i = 0; i < size; ++i) {
+		for (int b = 7; b >= 0; --b)
+			push((src[i] >> b) & 1);
+	}
+
+	for (int i = 0; i < tail; ++i)
+		push(0);
+}
+
+void convolutional_code::decode(const int8_t* soft, size_t size, char* dst) {
+	size_t steps = size * 8 + tail;
+	const __m128i base = _mm_set1_epi16(254), full = _mm_set1_epi16(508);
+
+	decisions.resize(steps);
+
+	// The encoder starts in state 0; the others start far enough behind to never win early.
+	for (int s = 0; s < 64; ++s)
+		metrics[s] = s == 0 ? 0 : 10000;
+
+	for (size_t t = 0; t < steps; ++t) {
+		__m128i s0 = _mm_set1_epi16(soft[2 * t]), s1 = _mm_set1_epi16(soft[2 * t + 1]);
+		__m128i d0[4], d1[4];
+
+		// Add-compare-select for all 32 butterflies, eight per register. Old states j and j + 32 feed new states 2j and 2j + 1.
+		for (int g = 0; g < 4; ++g) {
+			__m128i a = _mm_loadu_si128((__m128i*)(metrics + 8 * g));
+			__m128i b = _mm_loadu_si128((__m128i*)(metrics + 32 + 8 * g));
+			__m128i m0 = _mm_loadu_si128((__m128i*)(sign0 + 8 * g));
+			__m128i m1 = _mm_loadu_si128((__m128i*)(sign1 + 8 * g));
+
+			// Distance of the received pair from the branch label: 127 - s for an expected 1, 127 + s for a 0.
+			__m128i bm = _mm_add_epi16(base, _mm_add_epi16(_mm_sub_epi16(_mm_xor_si128(s0, m0), m0), _mm_sub_epi16(_mm_xor_si128(s1, m1), m1)));
+			__m128i bmc = _mm_sub_epi16(full, bm);
+
+			__m128i x0 = _mm_add_epi16(a, bm), y0 = _mm_add_epi16(b, bmc);
+			__m128i x1 = _mm_add_epi16(a, bmc), y1 = _mm_add_epi16(b, bm);
+			__m128i n0 = _mm_min_epi16(x0, y0), n1 = _mm_min_epi16(x1, y1);
+
+			d0[g] = _mm_cmpgt_epi16(x0, y0);
+			d1[g] = _mm_cmpgt_epi16(x1, y1);
+
+			_mm_storeu_si128((__m128i*)(next + 16 * g), _mm_unpacklo_epi16(n0, n1));
+			_mm_storeu_si128((__m128i*)(next + 16 * g + 8), _mm_unpackhi_epi16(n0, n1));
+		}
+
+		uint64_t dec0 = (uint32_t)_mm_movemask_epi8(_mm_packs_epi16(d0[0], d0[1])) | (uint32_t)_mm_movemask_epi8(_mm_packs_epi16(d0[2], d0[3])) << 16;
+		uint64_t dec1 = (uint32_t)_mm_movemask_epi8(_mm_packs_epi16(d1[0], d1[1])) | (uint32_t)_mm_movemask_epi8(_mm_packs_epi16(d1[2], d1[3])) << 16;
+
+		decisions[t] = dec0 | dec1 << 32;
+
+		// Only differences matter; keep the metrics near zero so 16 bits never overflow.
+		__m128i r = _mm_set1_epi16(next[0]);
+
+		for (int g = 0; g < 8; ++g)
+			_mm_storeu_si128((__m128i*)(metrics + 8 * g), _mm_sub_epi16(_mm_loadu_si128((__m128i*)(next + 8 * g)), r));
+	}
+
+	// The tail drives the encoder back to state 0, so trace back from there.
+	int state = 0;
+
+	for (size_t i = 0; i < size; ++i)
+		dst[i] = 0;
+
+	for (size_t t = steps; t-- > 0;) {
+		int bit = state & 1, j = state >> 1;
+		bool upper = (decisions[t] >> (bit ? 32 + j : j)) & 1;
+
+		if (t < size * 8 && bit)
+			dst[t / 8] |= 1 << (7 - t % 8);
+
+		state = j + (upper ? 32 : 0);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,97 @@
+#include "crc32c.h"
+#include <cstring>
+#include <nmmintrin.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#define SSE42_TARGET
+#else
+#include <cpuid.h>
+#define SSE42_TARGET __attribute__((target("sse4.2")))
+#endif
+
+static constexpr uint32_t polynomial = 0x82f63b78;
+
+struct slicing_table {
+	uint32_t t[8][256];
+
+	slicing_table() {
+		for (uint32_t i = 0; i < 256; ++i) {
+			uint32_t c = i;
+
+			for (int k = 0; k < 8; ++k)
+				c = c & 1 ? (c >> 1) ^ polynomial : c >> 1;
+
+			t[0][i] = c;
+		}
+
+		// t[j][i] is the CRC of byte i followed by j zero bytes, so eight lookups advance over a whole word.
+		for (int j = 1; j < 8; ++j) {
+			for (int i = 0; i < 256; ++i)
+				t[j][i] = (t[j - 1][i] >> 8) ^ t[0][t[j - 1][i] & 0xff];
+		}
+	}
+};
+
+static const slicing_table table;
+
+static bool has_sse42() {
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 1);
+	return (info[2] >> 20) & 1;
+#else
+	unsigned int a, b, c, d;
+	return __get_cpuid(1, &a, &b, &c, &d) && ((c >> 20) & 1);
+#endif
+}
+
+static const bool hardware = has_sse42();
+
+static uint32_t crc32c_slicing(const uint8_t* p, size_t size, uint32_t crc) {
+	for (; size > 0 && ((uintptr_t)p & 7) != 0; --size)
+		crc = (crc >> 8) ^ table.t[0][(crc ^ *p++) & 0xff];
+
+	for (; size >= 8; size -= 8, p += 8) {
+		uint64_t w;
+		memcpy(&w, p, 8);
+		w ^= crc;
+
+		crc = table.t[7][w & 0xff] ^ table.t[6][(w >> 8) & 0xff] ^ table.t[5][(w >> 16) & 0xff] ^ table.t[4][(w >> 24) & 0xff] ^
+			table.t[3][(w >> 32) & 0xff] ^ table.t[2][(w >> 40) & 0xff] ^ table.t[1][(w >> 48) & 0xff] ^ table.t[0][w >> 56];
+	}
+
+	for (; size > 0; --size)
+		crc = (crc >> 8) ^ table.t[0][(crc ^ *p++) & 0xff];
+
+	return crc;
+}
+
+SSE42_TARGET static uint32_t crc32c_sse42(const uint8_t* p, size_t size, uint32_t crc) {
+	for (; size > 0 && ((uintptr_t)p & 7) != 0; --size)
+		crc = _mm_crc32_u8(crc, *p++);
+
+	uint64_t c = crc;
+
+	for (; size >= 8; size -= 8, p += 8) {
+		uint64_t w;
+		memcpy(&w, p, 8);
+		c = _mm_crc32_u64(c, w);
+	}
+
+	crc = (uint32_t)c;
+
+	for (; size > 0; --size)
+		crc = _mm_crc32_u8(crc, *p++);
+
+	return crc;
+}
+
+uint32_t crc32c(const void* src, size_t size, uint32_t crc) {
+	const uint8_t* p = (const uint8_t*)src;
+
+	if (hardware)
+		return ~crc32c_sse42(p, size, ~crc);
+
+	return ~crc32c_slicing(p, size, ~crc);
+}
\ No newline at end of file
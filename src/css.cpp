@@ -0,0 +1,268 @@
+#include "css.h"
+#include <cmath>
+#include <bitset>
+
+int css::symbol_size(int sample_rate, int baud_rate, int spreading_factor, double low_freq) {
+	int chips = 1 << spreading_factor;
+	int n = 32;
+
+	while (n < 16384 && 1.4142 * n * baud_rate < (double)sample_rate * spreading_factor)
+		n *= 2;
+
+	while (n < 4 * chips)
+		n *= 2;
+
+	while (n < 16384) {
+		double bandwidth = (double)chips * sample_rate / n;
+
+		if (std::max(low_freq, bandwidth / 2 + 2.0 * sample_rate / n) + bandwidth <= 0.4 * sample_rate)
+			break;
+
+		n *= 2;
+	}
+
+	return n;
+}
+
+css::css(int sample_rate, int baud_rate, int spreading_factor, double low_freq) : modem_device(sample_rate, baud_rate),
+	spreading_factor(std::min(std::max(spreading_factor, 5), 12)), low_freq(low_freq),
+	transform(symbol_size(sample_rate, baud_rate, std::min(std::max(spreading_factor, 5), 12), low_freq))
+{
+	chips = 1 << this->spreading_factor;
+	samples_per_baud = transform.size();
+	bandwidth = (double)chips * sample_rate / samples_per_baud;
+	base_freq = std::max(low_freq, bandwidth / 2 + 2.0 * sample_rate / samples_per_baud);
+	min_samples = 12 * samples_per_baud;
+	guard = samples_per_baud / 8;
+	max_volume = 32767;
+	min_power = 0.005;
+	detect_contrast = 12;
+	timing_offset = 0;
+	timing_drift = 0;
+	tx_phase = 0;
+	received = 0;
+
+	chirp_cos.resize(samples_per_baud);
+	chirp_sin.resize(samples_per_baud);
+
+	for (int i = 0; i < samples_per_baud; ++i) {
+		double theta = 2 * pi * (base_freq * i + bandwidth * i * (i - 1) / (2.0 * samples_per_baud)) / m_sample_rate;
+
+		chirp_cos[i] = std::cos(theta);
+		chirp_sin[i] = std::sin(theta);
+	}
+}
+
+int css::detect(std::vector<short>& v, size_t idx, double& amplitude, double& contrast, double* offset) {
+	re.resize(samples_per_baud);
+	im.resize(samples_per_baud);
+	power.resize(chips);
+
+	for (int i = 0; i < samples_per_baud; ++i) {
+		double x = (double)v[idx + i] / max_volume;
+
+		re[i] = x * chirp_cos[i];
+		im[i] = -x * chirp_sin[i];
+	}
+
+	transform.forward(re, im);
+
+	// A shifted chirp wraps around once per symbol, so its energy lands in bin s and in its alias s - chips.
+	int ret = 0;
+	double sum = 0;
+
+	for (int s = 0; s < chips; ++s) {
+		int k = samples_per_baud - chips + s;
+		power[s] = re[s] * re[s] + im[s] * im[s] + re[k] * re[k] + im[k] * im[k];
+		sum += power[s];
+
+		if (power[s] > power[ret])
+			ret = s;
+	}
+
+	amplitude = std::sqrt(power[ret]) * 2 / samples_per_baud;
+	contrast = power[ret] * chips / (sum + 1e-12);
+
+	if (offset) {
+		double a = std::sqrt(power[(ret + chips - 1) % chips]);
+		double b = std::sqrt(power[ret]);
+		double c = std::sqrt(power[(ret + 1) % chips]);
+
+		// The dechirped tone is rectangular-windowed, so the neighbour ratio gives the fractional bin directly.
+		*offset = c > a ? c / (b + c) : -a / (a + b);
+	}
+
+	return ret;
+}
+
+void css::track(size_t& idx, double offset) {
+	// A late window shifts every symbol up by a fraction of a bin, so the offset drives a proportional-integral loop on the symbol clock.
+	double error = offset * samples_per_baud / chips;
+	double limit = samples_per_baud / 1000.0;
+
+	timing_drift = std::min(std::max(timing_drift + 0.02 * error, -limit), limit);
+	timing_offset += 0.2 * error + timing_drift;
+
+	int shift = (int)std::round(timing_offset);
+
+	if (shift != 0 && (shift < 0 || idx >= shift)) {
+		idx -= shift;
+		timing_offset -= shift;
+	}
+}
+
+int css::sync(std::vector<short>& v) {
+	if (v.size() < min_samples)
+		return -1;
+
+	double amplitude, contrast;
+	size_t idx;
+	int symbol = 0;
+	bool detected = false;
+
+	for (idx = 0; idx + min_samples < v.size(); idx += samples_per_baud) {
+		symbol = detect(v, idx, amplitude, contrast);
+
+		if (amplitude < min_power || contrast < detect_contrast)
+			continue;
+
+		int next = detect(v, idx + samples_per_baud, amplitude, contrast);
+		int diff = (next - symbol + chips) % chips;
+
+		if (amplitude >= min_power && contrast >= detect_contrast && (diff <= 1 || diff == chips - 1)) {
+			detected = true;
+			break;
+		}
+	}
+
+	if (!detected) {
+		v.erase(v.begin(), v.begin() + idx);
+		return -1;
+	}
+
+	// A preamble up-chirp observed tau samples late shows up as symbol tau * chips / N.
+	size_t start = idx;
+	size_t boundary = idx + samples_per_baud - (size_t)symbol * samples_per_baud / chips;
+	int step = samples_per_baud / chips;
+	int best = 0;
+	double max_val = -inf;
+
+	for (int d = -step; d <= step; ++d) {
+		detect(v, boundary + d, amplitude, contrast);
+		double val = power[0];
+
+		if (val > max_val) {
+			max_val = val;
+			best = d;
+		}
+	}
+
+	boundary += best;
+	timing_offset = 0;
+
+	for (idx = boundary; idx + 3LL * samples_per_baud < v.size(); idx += samples_per_baud) {
+		double offset;
+		symbol = detect(v, idx, amplitude, contrast, &offset);
+
+		if (symbol <= 1 || symbol >= chips - 1) {
+			track(idx, symbol == 0 ? offset : offset + (symbol == 1 ? 1 : -1));
+			continue;
+		}
+
+		int error = symbol - chips / 2;
+
+		if (std::abs(error) <= 1 && std::abs(detect(v, idx + samples_per_baud, amplitude, contrast) - chips / 4 - error) <= 1) {
+			v.erase(v.begin(), v.begin() + idx + 2LL * samples_per_baud - (long long)error * step - guard);
+			synchronized = true;
+			return 1;
+		}
+
+		v.erase(v.begin(), v.begin() + idx);
+		return -1;
+	}
+
+	v.erase(v.begin(), v.begin() + start);
+	return -1;
+}
+
+int css::demoulate(std::vector<short>& v, std::vector<char>& dst) {
+	double amplitude, contrast, offset;
+	size_t idx;
+
+	for (idx = guard; idx + 2LL * samples_per_baud < v.size(); idx += samples_per_baud) {
+		int symbol = detect(v, idx, amplitude, contrast, &offset);
+
+		if (amplitude < min_power || contrast < 2) {
+			synchronized = false;
+			buff = "";
+			received = 0;
+
+			v.erase(v.begin(), v.begin() + idx + samples_per_baud);
+			return -1;
+		}
+
+		int value = symbol ^ (symbol >> 1);
+		buff += std::bitset<16>(value).to_string().substr(16 - spreading_factor);
+
+		while (buff.size() >= 8 && received < frame_size) {
+			unsigned char c = std::bitset<8>(buff.substr(0, 8)).to_ulong();
+			dst.push_back(c);
+			buff.erase(0, 8);
+			received += 1;
+		}
+
+		if (received == frame_size) {
+			received = 0;
+			buff = "";
+			synchronized = false;
+			v.erase(v.begin(), v.begin() + idx + samples_per_baud);
+
+			return 1;
+		}
+
+		track(idx, offset);
+	}
+
+	// Keep a few samples before the next symbol so the clock can still be pulled back.
+	v.erase(v.begin(), v.begin() + idx - guard);
+	return 1;
+}
+
+void css::write(int symbol, std::vector<short>& dst) {
+	int step = samples_per_baud / chips;
+
+	for (int i = 0; i < samples_per_baud; ++i) {
+		double freq = base_freq + bandwidth * ((symbol * step + i) % samples_per_baud) / samples_per_baud;
+
+		dst.push_back(std::cos(tx_phase) * max_volume * 0.9);
+		tx_phase = std::fmod(tx_phase + 2 * pi * freq / m_sample_rate, 2 * pi);
+	}
+}
+
+void css::modulate(char* src, size_t size, std::vector<short>& dst) {
+	for (size_t i = 0; i < size; i += frame_size) {
+		size_t bits = std::min((size_t)frame_size, size - i) * 8;
+
+		for (int n = 0; n < 8; ++n)
+			write(0, dst);
+
+		write(chips / 2, dst);
+		write(chips / 4, dst);
+
+		for (size_t bit = 0; bit < bits; ) {
+			int value = 0;
+
+			for (int n = 0; n < spreading_factor; ++n, ++bit)
+				value = (value << 1) | (bit < bits ? (src[i + bit / 8] >> (7 - bit % 8)) & 1 : 0);
+
+			int symbol = value;
+
+			for (int m = value >> 1; m; m >>= 1)
+				symbol ^= m;
+
+			write(symbol, dst);
+		}
+	}
+
+	dst.insert(dst.end(), samples_per_baud, 0);
+}
\ No newline at end of file
@@ -0,0 +1,209 @@
+#include "delta.h"
+#include "crc32c.h"
+#include "varint.h"
+#include "packet.h"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <unordered_map>
+
+static constexpr size_t min_block = 64;
+static constexpr size_t max_block = 4096;
+
+// Every block costs its signature whether it matches or not, and a changed block costs its length; blocks near
+// sqrt(8 * size) balance the two for a handful of edits.
+static size_t block_size(size_t size) {
+	size_t block = (size_t)std::sqrt(8.0 * size) / 16 * 16;
+
+	return std::min(std::max(block, min_block), max_block);
+}
+
+static void put_u32(uint32_t v, std::vector<char>& dst) {
+	dst.insert(dst.end(), (char*)&v, (char*)&v + sizeof(v));
+}
+
+static bool get_u32(const char*& p, const char* end, uint32_t& v) {
+	if (end - p < (ptrdiff_t)sizeof(v))
+		return false;
+
+	memcpy(&v, p, sizeof(v));
+	p += sizeof(v);
+
+	return true;
+}
+
+// The rsync checksum: a plain byte sum and a position-weighted one, both of which slide along in constant time.
+struct rolling_sum {
+	uint32_t a = 0, b = 0;
+	size_t len = 0;
+
+	void reset(const char* p, size_t n) {
+		a = b = 0;
+		len = n;
+
+		for (size_t i = 0; i < n; ++i) {
+			a += (uint8_t)p[i];
+			b += (uint32_t)(n - i) * (uint8_t)p[i];
+		}
+	}
+
+	void roll(uint8_t out, uint8_t in) {
+		a += in - out;
+		b += a - (uint32_t)len * out;
+	}
+
+	uint32_t value() { return (a & 0xffff) | b << 16; }
+};
+
+void build_signatures(const char* basis, size_t size, std::vector<char>& dst) {
+	size_t block = block_size(size);
+
+	put_varint(block, dst);
+	put_varint(size / block, dst);
+
+	// A short last block is left out; the other side sends those bytes as they are.
+	for (size_t i = 0; i + block <= size; i += block) {
+		rolling_sum sum;
+		sum.reset(basis + i, block);
+
+		put_u32(sum.value(), dst);
+		put_u32(crc32c(basis + i, block), dst);
+	}
+}
+
+bool build_delta(const char* src, size_t size, const char* signatures, size_t sig_size, std::vector<char>& dst) {
+	const char* p = signatures, * end = signatures + sig_size;
+	size_t block, count;
+
+	if (!get_varint(p, end, block) || !get_varint(p, end, count) || block == 0 || count > (size_t)(end - p) / 8)
+		return false;
+
+	std::unordered_multimap<uint32_t, std::pair<uint32_t, size_t>> blocks;
+
+	for (size_t i = 0; i < count; ++i) {
+		uint32_t weak, strong;
+		get_u32(p, end, weak);
+		get_u32(p, end, strong);
+		blocks.emplace(weak, std::make_pair(strong, i));
+	}
+
+	put_varint(size, dst);
+	put_u32(crc32c(src, size), dst);
+
+	size_t literal = 0, run_start = 0, run_length = 0;
+
+	auto flush_run = [&]() {
+		if (run_length == 0)
+			return;
+
+		put_varint(run_length << 1 | 1, dst);
+		put_varint(run_start, dst);
+		run_length = 0;
+	};
+
+	auto flush_literal = [&](size_t to) {
+		if (to == literal)
+			return;
+
+		flush_run();
+		put_varint((to - literal) << 1, dst);
+		dst.insert(dst.end(), src + literal, src + to);
+	};
+
+	rolling_sum sum;
+	size_t pos = 0;
+
+	if (size >= block)
+		sum.reset(src, block);
+
+	while (pos + block <= size) {
+		auto range = blocks.equal_range(sum.value());
+		size_t found = count;
+
+		if (range.first != range.second) {
+			uint32_t strong = crc32c(src + pos, block);
+
+			for (auto it = range.first; it != range.second; ++it) {
+				if (it->second.first == strong) {
+					found = it->second.second;
+					break;
+				}
+			}
+		}
+
+		if (found == count) {
+			if (pos + block < size)
+				sum.roll(src[pos], src[pos + block]);
+
+			pos += 1;
+			continue;
+		}
+
+		// Neighbouring blocks that follow on from each other in the old copy go out as one reference.
+		flush_literal(pos);
+
+		if (run_length > 0 && run_start + run_length == found)
+			run_length += 1;
+
+		else {
+			flush_run();
+			run_start = found;
+			run_length = 1;
+		}
+
+		pos += block;
+		literal = pos;
+
+		if (pos + block <= size)
+			sum.reset(src + pos, block);
+	}
+
+	flush_literal(size);
+	flush_run();
+
+	return true;
+}
+
+bool apply_delta(const char* basis, size_t basis_size, const char* delta, size_t delta_size, std::vector<char>& dst) {
+	const char* p = delta, * end = delta + delta_size;
+	size_t size, block = block_size(basis_size);
+	uint32_t crc;
+
+	// The rebuilt file has to fit in one packet like any other, so a length past that is damage or an attack.
+	if (!get_varint(p, end, size) || size > max_data_size || !get_u32(p, end, crc))
+		return false;
+
+	std::vector<char> out;
+	out.reserve(size);
+
+	while (p < end) {
+		size_t op, start;
+
+		if (!get_varint(p, end, op))
+			return false;
+
+		size_t n = op >> 1;
+
+		if (!(op & 1)) {
+			if (n > (size_t)(end - p) || n > size - out.size())
+				return false;
+
+			out.insert(out.end(), p, p + n);
+			p += n;
+			continue;
+		}
+
+		size_t blocks = basis_size / block;
+
+		if (!get_varint(p, end, start) || start > blocks || n > blocks - start || n > (size - out.size()) / block)
+			return false;
+
+		out.insert(out.end(), basis + start * block, basis + (start + n) * block);
+	}
+
+	if (out.size() != size || crc32c(out.data(), out.size()) != crc)
+		return false;
+
+	dst = std::move(out);
+	return true;
+}
\ No newline at end of file
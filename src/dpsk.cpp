@@ -0,0 +1,252 @@
+#include "dpsk.h"
+
+#include <cmath>
+#include <bitset>
+
+dpsk::dpsk(int sample_rate, int baud_rate, modem_type type, int frame_length) : modem_device(sample_rate, baud_rate), m_type(type) {
+	bits_per_symbol = m_type == modem_type::dbpsk ? 1 : 2;
+	samples_per_baud = bits_per_symbol * sample_rate / baud_rate;
+	min_samples = 20 * samples_per_baud;
+	max_volume = INT16_MAX;
+	threshold = 0.5;
+	received = 0;
+	prev_cos = 1;
+	prev_sin = 0;
+	timing_error = 0;
+	tx_phase = 0;
+	m_frame_length = std::max(1, frame_length / frame_size) * frame_size;
+
+	_cos.assign(samples_per_baud, 0);
+	_sin.assign(samples_per_baud, 0);
+
+	for (int i = 0; i < samples_per_baud; ++i) {
+		double theta = 2 * pi * i / samples_per_baud;
+		_cos[i] = std::cos(theta);
+		_sin[i] = std::sin(theta);
+	}
+}
+
+void dpsk::phase(std::vector<short>& v, size_t idx, double& cos, double& sin, size_t len) {
+	cos = 0, sin = 0;
+
+	if (len == 0)
+		len = samples_per_baud;
+
+	for (int i = 0; i < len; ++i) {
+		double x = (double)v[idx + i] / max_volume;
+		int t = i % samples_per_baud;
+
+		cos += _cos[t] * x;
+		sin -= _sin[t] * x;
+	}
+
+	cos = cos * 2 / len;
+	sin = sin * 2 / len;
+}
+
+double dpsk::transition(std::vector<short>& v, size_t idx) {
+	double c0, s0, c1, s1, c2, s2;
+
+	phase(v, idx - 2LL * samples_per_baud, c0, s0);
+	phase(v, idx - samples_per_baud, c1, s1);
+	phase(v, idx, c2, s2);
+
+	double same = c1 * c0 + s1 * s0;
+	double flip = -(c2 * c1 + s2 * s1);
+
+	return same + flip;
+}
+
+int dpsk::sync(std::vector<short>& v) {
+	if (v.size() < min_samples)
+		return -1;
+
+	size_t idx;
+	double cos, sin;
+	bool detected = false;
+
+	for (idx = 0; idx + min_samples < v.size(); idx += samples_per_baud) {
+		phase(v, idx, cos, sin);
+		double power = std::sqrt(cos * cos + sin * sin);
+
+		if (power > threshold) {
+			detected = true;
+			break;
+		}
+	}
+
+	if (!detected) {
+		v.erase(v.begin(), v.begin() + idx);
+		return -1;
+	}
+
+	size_t start = idx;
+
+	prev_cos = cos;
+	prev_sin = sin;
+
+	for (idx += samples_per_baud; idx + min_samples < v.size(); idx += samples_per_baud) {
+		phase(v, idx, cos, sin);
+
+		if (cos * prev_cos + sin * prev_sin >= 0) {
+			prev_cos = cos;
+			prev_sin = sin;
+			continue;
+		}
+
+		// The reversal lies within one symbol of idx; refine coarsely, then sample by sample.
+		size_t from = std::max<size_t>(idx - samples_per_baud / 2, start + 2LL * samples_per_baud);
+		size_t max_idx = from;
+		double max_val = -inf;
+		int step = std::max(1, samples_per_baud / 8);
+
+		for (size_t i = from; i < idx + samples_per_baud / 2; i += step) {
+			double val = transition(v, i);
+
+			if (val > max_val) {
+				max_val = val;
+				max_idx = i;
+			}
+		}
+
+		from = max_idx > from + step ? max_idx - step : from;
+
+		for (size_t i = from; i < max_idx + step; ++i) {
+			double val = transition(v, i);
+
+			if (val > max_val) {
+				max_val = val;
+				max_idx = i;
+			}
+		}
+
+		phase(v, max_idx, prev_cos, prev_sin);
+		v.erase(v.begin(), v.begin() + max_idx + samples_per_baud);
+
+		buff = "";
+		received = 0;
+		timing_error = 0;
+		synchronized = true;
+		return 1;
+	}
+
+	v.erase(v.begin(), v.begin() + start);
+	return -1;
+}
+
+int dpsk::demoulate(std::vector<short>& v, std::vector<char>& dst) {
+	double cos, sin;
+	size_t idx;
+
+	for (idx = 0; idx + min_samples < v.size(); idx += samples_per_baud) {
+		phase(v, idx, cos, sin);
+		double power = std::sqrt(cos * cos + sin * sin);
+
+		if (power < threshold) {
+			// A burst may carry fewer than m_frame_length bytes; silence on a frame boundary ends it cleanly.
+			bool complete = received > 0 && received % frame_size == 0 && buff.empty();
+
+			synchronized = false;
+			buff = "";
+			received = 0;
+
+			v.erase(v.begin(), v.begin() + idx + samples_per_baud);
+			return complete ? 1 : -1;
+		}
+
+		// Early-late gate: nudge the symbol clock towards the window with the most energy.
+		int d = samples_per_baud / 8;
+
+		if (idx >= d) {
+			double e_cos, e_sin, l_cos, l_sin;
+			phase(v, idx - d, e_cos, e_sin);
+			phase(v, idx + d, l_cos, l_sin);
+
+			timing_error += std::sqrt(l_cos * l_cos + l_sin * l_sin) - std::sqrt(e_cos * e_cos + e_sin * e_sin);
+
+			if (timing_error > 0.5) {
+				idx += 1;
+				timing_error = 0;
+				phase(v, idx, cos, sin);
+			}
+
+			else if (timing_error < -0.5) {
+				idx -= 1;
+				timing_error = 0;
+				phase(v, idx, cos, sin);
+			}
+		}
+
+		double d_cos = cos * prev_cos + sin * prev_sin;
+		double d_sin = sin * prev_cos - cos * prev_sin;
+
+		prev_cos = cos;
+		prev_sin = sin;
+
+		if (bits_per_symbol == 1)
+			buff += d_cos < 0 ? '1' : '0';
+
+		else {
+			buff += d_cos + d_sin < 0 ? '1' : '0';
+			buff += d_cos - d_sin < 0 ? '1' : '0';
+		}
+
+		if (buff.size() == 8) {
+			unsigned char c = std::bitset<8>(buff).to_ulong();
+			dst.push_back(c);
+			buff = "";
+			received += 1;
+		}
+
+		if (received == m_frame_length) {
+			received = 0;
+			synchronized = false;
+			v.erase(v.begin(), v.begin() + idx + samples_per_baud);
+
+			return 1;
+		}
+	}
+
+	v.erase(v.begin(), v.begin() + idx);
+	return 1;
+}
+
+void dpsk::modulate(char* src, size_t size, std::vector<short>& dst) {
+	const double step[4] = { 0, pi / 2, 3 * pi / 2, pi };
+
+	for (int i = 0; i < size; ++i) {
+		if (i % m_frame_length == 0) {
+			tx_phase = 0;
+
+			for (int n = 0; n < 6; ++n)
+				write(1, 0, dst);
+
+			tx_phase = pi;
+			write(-1, 0, dst);
+		}
+
+		std::bitset<8> bits(src[i]);
+
+		for (int b = 7; b >= 0; b -= bits_per_symbol) {
+			if (bits_per_symbol == 1)
+				tx_phase += bits[b] ? pi : 0;
+
+			else
+				tx_phase += step[bits[b] * 2 + bits[b - 1]];
+
+			write(std::cos(tx_phase), std::sin(tx_phase), dst);
+		}
+	}
+
+	dst.insert(dst.end(), 2LL * samples_per_baud, 0);
+}
+
+void dpsk::write(double cos, double sin, std::vector<short>& dst) {
+	size_t idx = dst.size();
+
+	dst.insert(dst.end(), samples_per_baud, 0);
+
+	for (int i = 0; i < samples_per_baud; ++i) {
+		dst[idx + i] = max_volume * (_cos[i] * cos - _sin[i] * sin) * 0.9;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,333 @@
+#include "fountain.h"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+fountain_code::fountain_code(size_t blocks) : k(std::max(blocks, (size_t)1)) {
+	// Robust soliton: the ideal 1/d(d-1) spread plus extra weight on low degrees and a spike at k/R, which keeps
+	// enough single-block symbols around for peeling to finish.
+	double r = spike_c * std::log(k / failure) * std::sqrt((double)k);
+	size_t spike = (size_t)std::min(std::max(std::round(k / std::max(r, 1.0)), 1.0), (double)k);
+	double sum = 0;
+
+	cdf.resize(k);
+
+	for (size_t d = 1; d <= k; ++d) {
+		double p = d == 1 ? 1.0 / k : 1.0 / (d * (d - 1.0));
+
+		if (d < spike)
+			p += r / (d * k);
+
+		else if (d == spike)
+			p += std::max(r * std::log(r / failure) / k, 0.0);
+
+		sum += p;
+		cdf[d - 1] = sum;
+	}
+
+	for (auto& c : cdf)
+		c /= sum;
+}
+
+void fountain_code::neighbours(uint32_t index, std::vector<uint32_t>& dst) {
+	dst.clear();
+
+	// Both ends draw from the same xorshift sequence, so the index is all a receiver needs.
+	uint32_t s = (index * 2654435761u + 0x9e3779b9u) | 1;
+
+	auto next = [&s]() {
+		s ^= s << 13;
+		s ^= s >> 17;
+		s ^= s << 5;
+		return s;
+	};
+
+	size_t degree = std::upper_bound(cdf.begin(), cdf.end(), next() / 4294967296.0) - cdf.begin() + 1;
+	degree = std::min(degree, k);
+
+	while (dst.size() < degree) {
+		uint32_t block = next() % k;
+
+		if (std::find(dst.begin(), dst.end(), block) == dst.end())
+			dst.push_back(block);
+	}
+}
+
+fountain_encoder::fountain_encoder(const std::vector<char>& src, size_t payload) :
+	data(src), symbol(payload - fountain_header_size), length(src.size()), code((src.size() + symbol - 1) / symbol)
+{
+	data.resize(code.blocks() * symbol, 0);
+}
+
+void fountain_encoder::build_frame(uint32_t index, std::vector<char>& dst) {
+	frame_header frame(data[0], frame_type::fountain, (uint16_t)index);
+	fountain_header header(index, (uint16_t)length);
+	size_t idx = dst.size();
+
+	dst.insert(dst.end(), (char*)&frame, (char*)&frame + frame_header_size);
+	dst.insert(dst.end(), (char*)&header, (char*)&header + fountain_header_size);
+	dst.resize(idx + frame_size, 0);
+
+	char* out = dst.data() + idx + frame_header_size + fountain_header_size;
+	code.neighbours(index, picked);
+
+	for (uint32_t block : picked) {
+		const char* in = data.data() + block * symbol;
+
+		for (size_t i = 0; i < symbol; ++i)
+			out[i] ^= in[i];
+	}
+
+	seal_frame(dst.data() + idx);
+}
+
+fountain_decoder::fountain_decoder(size_t length, size_t symbol) :
+	symbol(symbol), length(length), code((length + symbol - 1) / symbol), m_received(0), m_recovered(0),
+	solving(false), words(0)
+{
+	data.resize(code.blocks() * symbol, 0);
+	known.resize(code.blocks(), false);
+	watching.resize(code.blocks());
+	column.resize(code.blocks(), -1);
+}
+
+void fountain_decoder::resolve(uint32_t block, const char* src) {
+	if (known[block])
+		return;
+
+	memcpy(data.data() + block * symbol, src, symbol);
+	known[block] = true;
+	m_recovered += 1;
+	queue.push_back(block);
+}
+
+void fountain_decoder::peel() {
+	while (!queue.empty()) {
+		uint32_t block = queue.back();
+		const char* in = data.data() + block * symbol;
+		queue.pop_back();
+
+		for (uint32_t i : watching[block]) {
+			equation& e = equations[i];
+			auto found = std::find(e.blocks.begin(), e.blocks.end(), block);
+
+			if (found == e.blocks.end())
+				continue;
+
+			e.blocks.erase(found);
+
+			for (size_t j = 0; j < symbol; ++j)
+				e.data[j] ^= in[j];
+
+			// Down to one unknown block, the symbol now is that block.
+			if (e.blocks.size() == 1) {
+				uint32_t last = e.blocks[0];
+				e.blocks.clear();
+				resolve(last, e.data.data());
+			}
+		}
+
+		watching[block].clear();
+	}
+}
+
+void fountain_decoder::eliminate() {
+	for (uint32_t b = 0; b < code.blocks(); ++b) {
+		if (!known[b]) {
+			column[b] = (int)unknown.size();
+			unknown.push_back(b);
+		}
+	}
+
+	words = (unknown.size() + 63) / 64;
+	pivot_row.assign(unknown.size(), -1);
+	solving = true;
+
+	for (auto& e : equations) {
+		if (!e.blocks.empty())
+			reduce(e.blocks, e.data.data());
+	}
+
+	queue.clear();
+	equations.clear();
+	watching.assign(code.blocks(), {});
+}
+
+// Gauss-Jordan over GF(2), one row at a time, carrying the symbol sums along with the rows. A new row is cleared of
+// the existing pivots, takes its lowest remaining column as its own and clears that from the others, so each
+// symbol costs a pass over the rows instead of a fresh elimination.
+void fountain_decoder::reduce(const std::vector<uint32_t>& blocks, const char* src) {
+	size_t r = pivots.size();
+
+	bits.resize((r + 1) * words, 0);
+	sums.insert(sums.end(), src, src + symbol);
+
+	auto combine = [this](size_t to, size_t from) {
+		for (size_t w = 0; w < words; ++w)
+			bits[to * words + w] ^= bits[from * words + w];
+
+		for (size_t j = 0; j < symbol; ++j)
+			sums[to * symbol + j] ^= sums[from * symbol + j];
+	};
+
+	auto has = [this](size_t row, size_t c) {
+		return (bits[row * words + c / 64] >> (c % 64)) & 1;
+	};
+
+	for (uint32_t b : blocks)
+		bits[r * words + column[b] / 64] |= 1ull << (column[b] % 64);
+
+	size_t lead = unknown.size();
+
+	for (size_t c = 0; c < unknown.size(); ++c) {
+		if (!has(r, c))
+			continue;
+
+		if (pivot_row[c] >= 0)
+			combine(r, pivot_row[c]);
+
+		else if (lead == unknown.size())
+			lead = c;
+	}
+
+	// Nothing left means the symbol told us nothing new.
+	if (lead == unknown.size()) {
+		bits.resize(r * words);
+		sums.resize(r * symbol);
+		return;
+	}
+
+	pivot_row[lead] = (int)r;
+	pivots.push_back((uint32_t)lead);
+
+	for (size_t q = 0; q < r; ++q) {
+		if (has(q, lead))
+			combine(q, r);
+	}
+
+	// A row down to its pivot is that block; the others wait for more symbols.
+	for (size_t q = 0; q <= r; ++q) {
+		size_t set = 0;
+
+		for (size_t w = 0; w < words && set < 2; ++w) {
+			uint64_t v = bits[q * words + w];
+
+			if (v)
+				set += v & (v - 1) ? 2 : 1;
+		}
+
+		if (set == 1)
+			resolve(unknown[pivots[q]], sums.data() + q * symbol);
+	}
+}
+
+bool fountain_decoder::push(uint32_t index, const char* src) {
+	if (finished())
+		return true;
+
+	m_received += 1;
+	code.neighbours(index, picked);
+
+	equation e;
+	e.data.assign(src, src + symbol);
+
+	for (uint32_t block : picked) {
+		if (!known[block]) {
+			e.blocks.push_back(block);
+			continue;
+		}
+
+		const char* in = data.data() + block * symbol;
+
+		for (size_t j = 0; j < symbol; ++j)
+			e.data[j] ^= in[j];
+	}
+
+	if (solving && !e.blocks.empty())
+		reduce(e.blocks, e.data.data());
+
+	else if (e.blocks.size() == 1)
+		resolve(e.blocks[0], e.data.data());
+
+	else if (e.blocks.size() > 1) {
+		for (uint32_t block : e.blocks)
+			watching[block].push_back((uint32_t)equations.size());
+
+		equations.push_back(std::move(e));
+	}
+
+	peel();
+
+	if (!solving && !finished() && m_received >= code.blocks())
+		eliminate();
+
+	return finished();
+}
+
+std::vector<char> fountain_decoder::packet_data() {
+	return std::vector<char>(data.begin(), data.begin() + length);
+}
+
+packet* fountain_assembler::push(const char* frame) {
+	frame_header* header = (frame_header*)frame;
+	fountain_header* f_header = (fountain_header*)(frame + frame_header_size);
+
+	m_current = NULL;
+
+	if (header->type != (uint8_t)frame_type::fountain || f_header->length < header_size)
+		return NULL;
+
+	// A broadcast keeps going after we have it, so remember what is finished and let the rest of it pass.
+	uint32_t key = (uint32_t)header->id << 16 | f_header->length;
+
+	if (std::find(done.begin(), done.end(), key) != done.end())
+		return NULL;
+
+	auto found = pending.find(key);
+
+	if (found == pending.end()) {
+		if (pending.size() >= max_pending) {
+			pending.erase(order.front());
+			order.pop_front();
+		}
+
+		found = pending.emplace(key, fountain_decoder(f_header->length, payload - fountain_header_size)).first;
+		order.push_back(key);
+	}
+
+	fountain_decoder& decoder = found->second;
+	m_current = &decoder;
+
+	if (!decoder.push(f_header->index, frame + frame_header_size + fountain_header_size))
+		return NULL;
+
+	std::vector<char> data = decoder.packet_data();
+	packet* p = new packet();
+	p->push(data.data(), data.size());
+
+	pending.erase(found);
+	order.erase(std::find(order.begin(), order.end(), key));
+	done.push_back(key);
+	m_current = NULL;
+
+	if (done.size() > max_done)
+		done.pop_front();
+
+	return p;
+}
+
+bool fountain_assembler::progress(size_t& received, size_t& length) {
+	if (!m_current)
+		return false;
+
+	length = m_current->packet_length();
+	received = m_current->recovered();
+
+	return true;
+}
+
+void fountain_assembler::clear() {
+	pending.clear();
+	order.clear();
+	m_current = NULL;
+}
\ No newline at end of file
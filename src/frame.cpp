@@ -0,0 +1,307 @@
+#include "frame.h"
+#include "crc32c.h"
+#include "reed_solomon.h"
+#include "ldpc.h"
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+
+size_t frame_count(size_t packet_size, size_t payload) {
+	return (packet_size + payload - 1) / payload;
+}
+
+void build_frame(const std::vector<char>& src, uint16_t seq, std::vector<char>& dst, size_t payload) {
+	frame_header header(src[0], frame_type::data, seq);
+	size_t idx = dst.size();
+	size_t offset = (size_t)seq * payload;
+	size_t len = std::min(payload, src.size() - offset);
+
+	dst.insert(dst.end(), (char*)&header, (char*)&header + frame_header_size);
+	dst.insert(dst.end(), src.begin() + offset, src.begin() + offset + len);
+	dst.insert(dst.end(), frame_payload_size - len, 0);
+
+	seal_frame(dst.data() + idx);
+}
+
+static uint32_t frame_crc(const char* frame) {
+	uint32_t ret = crc32c(frame, offsetof(frame_header, crc));
+
+	return crc32c(frame + frame_header_size, frame_payload_size, ret);
+}
+
+// Tops up an interleaved group; receivers drop it like any frame that is not data.
+void build_fill_frame(std::vector<char>& dst) {
+	frame_header header(0, frame_type::fill, 0);
+	size_t idx = dst.size();
+
+	dst.insert(dst.end(), (char*)&header, (char*)&header + frame_header_size);
+	dst.resize(idx + frame_size, 0);
+	seal_frame(dst.data() + idx);
+}
+
+void seal_frame(char* frame) {
+	((frame_header*)frame)->crc = frame_crc(frame);
+}
+
+bool frame_intact(const char* frame) {
+	return ((frame_header*)frame)->crc == frame_crc(frame);
+}
+
+static reed_solomon codec(fec_parity_size);
+static ldpc_code ldpc(frame_size * 8 / ldpc_code::base_columns, ldpc_rate::three_quarters);
+static constexpr int erasure_step = 4;
+
+void protect_frame(char* frame, fec_scheme scheme) {
+	char* parity = frame + frame_size - fec_parity_size;
+
+	// The CRC is taken with the parity bytes zeroed, which is how repair_frame leaves them.
+	memset(parity, 0, fec_parity_size);
+	seal_frame(frame);
+
+	if (scheme == fec_scheme::ldpc)
+		ldpc.encode((uint8_t*)frame, (uint8_t*)parity);
+
+	else
+		codec.encode((uint8_t*)frame, frame_size - fec_parity_size, (uint8_t*)parity);
+}
+
+static bool try_repair(char* frame, const size_t* erasures, int count) {
+	char block[frame_size];
+	memcpy(block, frame, frame_size);
+
+	if (codec.decode((uint8_t*)block, frame_size, erasures, count) < 0)
+		return false;
+
+	memset(block + frame_size - fec_parity_size, 0, fec_parity_size);
+
+	if (!frame_intact(block))
+		return false;
+
+	memcpy(frame, block, frame_size);
+	return true;
+}
+
+static bool decode_ldpc(char* frame, const int8_t* llr) {
+	char block[frame_size];
+	int8_t hard[frame_size * 8];
+
+	// Without soft bits every decision counts as certain, which still lets the parity checks fix a few.
+	if (!llr) {
+		for (size_t i = 0; i < frame_size * 8; ++i)
+			hard[i] = (frame[i / 8] >> (7 - i % 8)) & 1 ? INT8_MAX : -INT8_MAX;
+
+		llr = hard;
+	}
+
+	ldpc.decode(llr, (uint8_t*)block);
+	memset(block + frame_size - fec_parity_size, 0, fec_parity_size);
+
+	if (!frame_intact(block))
+		return false;
+
+	memcpy(frame, block, frame_size);
+	return true;
+}
+
+bool repair_frame(char* frame, const int8_t* llr, fec_scheme scheme) {
+	if (scheme == fec_scheme::ldpc)
+		return decode_ldpc(frame, llr);
+
+	if (try_repair(frame, nullptr, 0))
+		return true;
+
+	if (!llr)
+		return false;
+
+	// A byte is as reliable as its weakest bit.
+	uint8_t reliability[frame_size];
+	size_t order[frame_size];
+
+	for (size_t i = 0; i < frame_size; ++i) {
+		reliability[i] = UINT8_MAX;
+
+		for (size_t b = 0; b < 8; ++b)
+			reliability[i] = std::min(reliability[i], (uint8_t)std::abs(llr[i * 8 + b]));
+
+		order[i] = i;
+	}
+
+	if (std::all_of(reliability, reliability + frame_size, [&](uint8_t r) { return r == reliability[0]; }))
+		return false;
+
+	std::stable_sort(order, order + frame_size, [&](size_t a, size_t b) { return reliability[a] < reliability[b]; });
+
+	// Generalized minimum distance: erase ever more of the weakest bytes until one attempt passes the CRC.
+	for (int count = erasure_step; count <= (int)fec_parity_size; count += erasure_step) {
+		if (try_repair(frame, order, count))
+			return true;
+	}
+
+	return false;
+}
+
+void build_nack_frame(uint8_t id, const std::vector<uint16_t>& seqs, uint16_t from, std::vector<char>& dst, size_t payload) {
+	size_t bits = (payload - sizeof(nack_header)) * 8;
+	frame_header header(id, frame_type::nack, 0);
+	size_t idx = dst.size();
+
+	for (uint16_t seq : seqs) {
+		if (seq >= bits)
+			from = std::min(from, seq);
+	}
+
+	nack_header nack(from);
+
+	dst.insert(dst.end(), (char*)&header, (char*)&header + frame_header_size);
+	dst.insert(dst.end(), (char*)&nack, (char*)&nack + sizeof(nack_header));
+	dst.resize(idx + frame_size, 0);
+
+	char* bitmap = dst.data() + idx + frame_header_size + sizeof(nack_header);
+
+	for (uint16_t seq : seqs) {
+		if (seq < bits)
+			bitmap[seq / 8] |= 1 << (seq % 8);
+	}
+
+	seal_frame(dst.data() + idx);
+}
+
+bool parse_nack_frame(const char* frame, uint8_t& id, std::vector<uint16_t>& seqs, uint16_t& from, size_t payload) {
+	frame_header* header = (frame_header*)frame;
+
+	if (header->type != (uint8_t)frame_type::nack)
+		return false;
+
+	const char* bitmap = frame + frame_header_size + sizeof(nack_header);
+
+	id = header->id;
+	from = ((nack_header*)(frame + frame_header_size))->from;
+	seqs.clear();
+
+	for (size_t seq = 0; seq < (payload - sizeof(nack_header)) * 8; ++seq) {
+		if (bitmap[seq / 8] & (1 << (seq % 8)))
+			seqs.push_back((uint16_t)seq);
+	}
+
+	return true;
+}
+
+packet* frame_assembler::push(const char* frame) {
+	frame_header* header = (frame_header*)frame;
+	const char* data = frame + frame_header_size;
+
+	m_current = NULL;
+
+	if (header->type != (uint8_t)frame_type::data)
+		return NULL;
+
+	// A first frame whose length cannot even hold the packet header is damaged, and must not cut the entry short.
+	if (header->seq == 0 && ((packet_header*)data)->len < header_size)
+		return NULL;
+
+	// No packet runs this long, so the frame is damaged; turn it away before it opens an entry.
+	if (header->seq >= frame_count(max_packet_size, payload))
+		return NULL;
+
+	auto found = pending.find(header->id);
+
+	// Ids are reused, so a first frame that differs from the one we hold starts a new packet.
+	if (header->seq == 0 && found != pending.end()) {
+		auto first = found->second.frames.find(0);
+
+		if (first != found->second.frames.end() && memcmp(first->second.data(), data, payload) != 0)
+			pending.erase(found);
+	}
+
+	partial& entry = pending[header->id];
+
+	if (header->seq == 0) {
+		size_t length = ((packet_header*)data)->len;
+
+		entry.length = length;
+		entry.frames.erase(entry.frames.lower_bound((uint16_t)frame_count(length, payload)), entry.frames.end());
+	}
+
+	if (entry.length != 0 && header->seq >= frame_count(entry.length, payload))
+		return NULL;
+
+	// Frames may arrive in any order and repeats are harmless; the packet is done once every slot is filled.
+	entry.frames.emplace(header->seq, std::vector<char>(data, data + payload));
+
+	if (entry.length != 0 && entry.frames.size() == frame_count(entry.length, payload)) {
+		packet* ret = new packet();
+
+		for (auto& f : entry.frames)
+			ret->push(f.second.data(), std::min(payload, entry.length - ret->size()));
+
+		pending.erase(header->id);
+
+		return ret;
+	}
+
+	m_current = &entry;
+	return NULL;
+}
+
+std::vector<uint8_t> frame_assembler::incomplete() {
+	std::vector<uint8_t> ret;
+
+	for (auto& entry : pending)
+		ret.push_back(entry.first);
+
+	return ret;
+}
+
+bool frame_assembler::missing(uint8_t id, std::vector<uint16_t>& seqs, uint16_t& from) {
+	auto found = pending.find(id);
+
+	if (found == pending.end())
+		return false;
+
+	partial& entry = found->second;
+
+	if (++entry.requests > max_requests) {
+		drop(id);
+		return false;
+	}
+
+	// Without the first frame the length is unknown, so everything past the last frame seen is asked for too.
+	size_t total = entry.length != 0 ? frame_count(entry.length, payload) : entry.frames.rbegin()->first + 1;
+
+	seqs.clear();
+	from = entry.length != 0 ? no_seq : (uint16_t)total;
+
+	for (size_t seq = 0; seq < total; ++seq) {
+		if (!entry.frames.count((uint16_t)seq))
+			seqs.push_back((uint16_t)seq);
+	}
+
+	return true;
+}
+
+bool frame_assembler::progress(size_t& received, size_t& length) {
+	if (!m_current || m_current->length == 0)
+		return false;
+
+	length = m_current->length;
+	received = std::min(m_current->frames.size() * payload, length);
+
+	return true;
+}
+
+void frame_assembler::drop(uint8_t id) {
+	auto found = pending.find(id);
+
+	if (found == pending.end())
+		return;
+
+	if (m_current == &found->second)
+		m_current = NULL;
+
+	pending.erase(found);
+}
+
+void frame_assembler::clear() {
+	pending.clear();
+	m_current = NULL;
+}
\ No newline at end of file
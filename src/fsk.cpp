@@ -2,12 +2,14 @@
 #include <cmath>
 #include <bitset>
 
-fsk::fsk(int sample_rate, int baud_rate) : modem_device(sample_rate, baud_rate) {
+fsk::fsk(int sample_rate, int baud_rate, int carrier, double volume, bool coded) : modem_device(sample_rate, baud_rate), carrier(carrier), volume(volume), coded(coded) {
 	samples_per_baud = sample_rate / baud_rate;
 	min_samples = 20 * samples_per_baud;
 	max_volume = 32767;
-	threshold = 0.5;
+	threshold = 0.5 * volume / 0.9;
 	received = 0;
+	weak = 0;
+	tolerance = 0;
 
 	hi_cos.assign(samples_per_baud, 0);
 	hi_sin.assign(samples_per_baud, 0);
@@ -20,13 +22,13 @@ fsk::fsk(int sample_rate, int baud_rate) : modem_device(sample_rate, baud_rate)
 	for (int i = 0; i < samples_per_baud; ++i) {
 		double theta = 2 * pi * i / samples_per_baud;
 
-		hi_cos[i] = std::cos(2 * theta);
-		hi_sin[i] = std::sin(2 * theta);
-		lo_cos[i] = std::cos(theta);
-		lo_sin[i] = std::sin(theta);
+		hi_cos[i] = std::cos((carrier + 1) * theta);
+		hi_sin[i] = std::sin((carrier + 1) * theta);
+		lo_cos[i] = std::cos(carrier * theta);
+		lo_sin[i] = std::sin(carrier * theta);
 
-		high[i] = hi_cos[i] * max_volume * 0.9;
-		low[i] = lo_cos[i] * max_volume * 0.9;
+		high[i] = hi_cos[i] * max_volume * volume;
+		low[i] = lo_cos[i] * max_volume * volume;
 	}
 }
 
@@ -70,6 +72,30 @@ void fsk::phase(std::vector<short>& v, size_t idx, double& cos, double& sin, siz
 	sin = sin * 2 / len;
 }
 
+size_t fsk::align(std::vector<short>& v, size_t origin, long long step) {
+	// Above the first harmonic the preamble repeats every samples_per_baud / carrier samples. Both tones start each
+	// symbol at zero phase, so the phase step from the last low symbol to the high marker tells how late the window is.
+	// A window straddling the marker also picks up the low tone, so estimate once more from the corrected position.
+	for (int pass = 0; pass < 2; ++pass) {
+		size_t idx = origin + step * samples_per_baud / carrier;
+		double lo_c, lo_s, hi_c = 0, hi_s = 0;
+
+		phase(v, idx - samples_per_baud, lo_c, lo_s);
+
+		for (int i = 0; i < samples_per_baud; ++i) {
+			double x = (double)v[idx + i] / max_volume;
+
+			hi_c += hi_cos[i] * x;
+			hi_s -= hi_sin[i] * x;
+		}
+
+		double late = std::remainder(std::atan2(hi_s, hi_c) - std::atan2(lo_s, lo_c), 2 * pi) / (2 * pi) * samples_per_baud;
+		step = std::max(step - std::llround(late * carrier / samples_per_baud), 0LL);
+	}
+
+	return origin + step * samples_per_baud / carrier;
+}
+
 int fsk::sync(std::vector<short>& v) {
 	if (v.size() < min_samples)
 		return -1;
@@ -98,7 +124,7 @@ int fsk::sync(std::vector<short>& v) {
 	size_t max_idx = 0;
 	double max_val = -inf;
 
-	for (int i = idx; i < idx + samples_per_baud; ++i) {
+	for (int i = idx; i < idx + samples_per_baud / carrier; ++i) {
 		phase(v, i, cos, sin, samples_per_baud * 2LL);
 		double val = cos - std::abs(sin);
 
@@ -108,48 +134,85 @@ int fsk::sync(std::vector<short>& v) {
 		}
 	}
 
-	for (idx = max_idx; idx + min_samples < v.size(); idx += samples_per_baud) {
+	// The repeat period is not a whole number of samples above the first harmonic, so count periods from max_idx.
+	idx = max_idx;
+
+	for (long long step = 0; max_idx + step * samples_per_baud / carrier + min_samples < v.size(); ++step) {
+		idx = max_idx + step * samples_per_baud / carrier;
 		fft(v, idx, hi, lo);
 		if (hi > lo) {
+			idx = align(v, max_idx, step);
 			v.erase(v.begin(), v.begin() + idx + samples_per_baud);
 			synchronized = true;
 			return 1;
 		}
 	}
 
-	v.erase(v.begin(), v.begin() + idx);
+	// Ran out of samples before the marker: keep the preamble for the next call unless it has gone on far too long.
+	size_t start = max_idx - std::min(max_idx, (size_t)samples_per_baud);
+	v.erase(v.begin(), v.begin() + (idx - start > 16LL * samples_per_baud ? idx : start));
 	return  -1;
 }
 
 int fsk::demoulate(std::vector<short>& v, std::vector<char>& dst) {
+	std::vector<int8_t> llr;
+	return demoulate_soft(v, dst, llr);
+}
+
+int fsk::demoulate_soft(std::vector<short>& v, std::vector<char>& dst, std::vector<int8_t>& llr) {
 	double hi, lo;
 	size_t idx;
 
 	for (idx = 0; idx + min_samples < v.size(); idx += samples_per_baud) {
 		fft(v, idx, hi, lo);
 
-		if (std::max(hi, lo) < threshold) {
+		// Coded frames, and any the modem set a tolerance for, ride out faint symbols as weak soft values.
+		weak = std::max(hi, lo) < threshold ? weak + 1 : 0;
+
+		if (weak > std::max(coded ? max_weak : 0, tolerance)) {
 			synchronized = false;
+			weak = 0;
 			buff = "";
+			soft.clear();
 			received = 0;
 
 			v.erase(v.begin(), v.begin() + idx + samples_per_baud);
 			return -1;
 		}
 
-		buff += hi > lo ? '1' : '0';
-		
-		if (buff.size() == 8) {
-			unsigned char c = std::bitset<8>(buff).to_ulong();
-			dst.push_back(c);
-			buff = "";
-			received += 1;
+		// Keep how sure each decision was. Coded frames hand the whole frame to the Viterbi decoder, whose output is hard.
+		soft.push_back((int8_t)std::round(max_llr * (hi - lo) / std::max(hi + lo, threshold)));
+
+		if (coded) {
+			if (soft.size() == convolutional_code::coded_bits(frame_size)) {
+				size_t idx = dst.size();
+				dst.resize(idx + frame_size);
+				code.decode(soft.data(), frame_size, dst.data() + idx);
+				hard_llr(dst.data() + idx, frame_size, llr);
+				soft.clear();
+				received = frame_size;
+			}
+		}
+
+		else {
+			buff += hi > lo ? '1' : '0';
+
+			if (buff.size() == 8) {
+				unsigned char c = std::bitset<8>(buff).to_ulong();
+				dst.push_back(c);
+				llr.insert(llr.end(), soft.begin(), soft.end());
+				soft.clear();
+				buff = "";
+				received += 1;
+			}
 		}
 
-		if (received == 128) {
+		// Every frame goes out with two low symbols after it. Left in, they would read as the start of a preamble
+		// whose phase need not match the next frame's after a gap.
+		if (received == frame_size) {
 			received = 0;
 			synchronized = false;
-			v.erase(v.begin(), v.begin() + idx + samples_per_baud);
+			v.erase(v.begin(), v.begin() + idx + 3 * samples_per_baud);
 			
 			return 1;
 		}
@@ -161,7 +224,7 @@ int fsk::demoulate(std::vector<short>& v, std::vector<char>& dst) {
 
 void fsk::modulate(char* src, size_t size, std::vector<short>& dst) {
 	for (int i = 0; i < size; ++i) {
-		if (i % 128 == 0) {
+		if (i % frame_size == 0) {
 			dst.insert(dst.end(), low.begin(), low.end());
 			dst.insert(dst.end(), low.begin(), low.end());
 			dst.insert(dst.end(), low.begin(), low.end());
@@ -169,6 +232,20 @@ void fsk::modulate(char* src, size_t size, std::vector<short>& dst) {
 			dst.insert(dst.end(), low.begin(), low.end());
 			dst.insert(dst.end(), low.begin(), low.end());
 			dst.insert(dst.end(), high.begin(), high.end());
+
+			if (coded) {
+				std::vector<char> block(src + i, src + std::min(size, (size_t)i + frame_size));
+				std::vector<uint8_t> bits;
+
+				block.resize(frame_size, 0);
+				code.encode(block.data(), frame_size, bits);
+
+				for (uint8_t bit : bits)
+					dst.insert(dst.end(), bit ? high.begin() : low.begin(), bit ? high.end() : low.end());
+
+				i += frame_size - 1;
+				continue;
+			}
 		}
 
 		std::bitset<8> bits(src[i]);
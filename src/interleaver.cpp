@@ -0,0 +1,52 @@
+#include "interleaver.h"
+#include "modem_device.h"
+#include <algorithm>
+#include <cstring>
+
+interleaver::interleaver(int depth) : depth(std::min(std::max(depth, 1), max_depth)), filled(0) {
+	rows.resize(this->depth * frame_size);
+	row_llr.resize(this->depth * frame_size * 8);
+}
+
+void interleaver::interleave(const char* src, char* dst) {
+	for (int r = 0; r < depth; ++r) {
+		for (int j = 0; j < frame_size; ++j)
+			dst[j * depth + r] = src[r * frame_size + j];
+	}
+}
+
+bool interleaver::push(const char* frame, const int8_t* llr) {
+	if (filled == depth)
+		filled = 0;
+
+	memcpy(rows.data() + filled * frame_size, frame, frame_size);
+
+	if (llr)
+		memcpy(row_llr.data() + filled * frame_size * 8, llr, frame_size * 8);
+
+	else {
+		for (int i = 0; i < frame_size * 8; ++i)
+			row_llr[filled * frame_size * 8 + i] = (frame[i / 8] >> (7 - i % 8)) & 1 ? max_llr : -max_llr;
+	}
+
+	return ++filled == depth;
+}
+
+void interleaver::pop(std::vector<char>& dst, std::vector<int8_t>& llr) {
+	size_t idx = dst.size(), llr_idx = llr.size();
+
+	dst.resize(idx + depth * frame_size);
+	llr.resize(llr_idx + depth * frame_size * 8);
+
+	// Received frame k carries stream bytes k * frame_size on; stream byte j * depth + r belongs to byte j of frame r.
+	for (int r = 0; r < depth; ++r) {
+		for (int j = 0; j < frame_size; ++j) {
+			int k = j * depth + r;
+
+			dst[idx + r * frame_size + j] = rows[k];
+			memcpy(llr.data() + llr_idx + (r * frame_size + j) * 8, row_llr.data() + k * 8, 8);
+		}
+	}
+
+	filled = 0;
+}
\ No newline at end of file
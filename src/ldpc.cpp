@@ -0,0 +1,230 @@
+#include "ldpc.h"
+#include <cstring>
+#include <algorithm>
+#include <emmintrin.h>
+
+ldpc_code::ldpc_code(int z, ldpc_rate rate) : z(std::min(std::max(z / 8 * 8, 8), 256)), columns(base_columns) {
+	rows = rate == ldpc_rate::half ? 16 : rate == ldpc_rate::three_quarters ? 8 : 4;
+	build();
+
+	size_t edges = 0, degree = 0;
+
+	for (auto& layer : layers) {
+		edges += layer.size();
+		degree = std::max(degree, layer.size());
+	}
+
+	app.resize(block_bits());
+	messages.resize(edges * this->z);
+	extrinsic.resize(degree * this->z);
+	rotated.resize(this->z);
+}
+
+void ldpc_code::build() {
+	int info = columns - rows;
+	int mid = rows / 2;
+	std::vector<std::vector<int>> shift(rows, std::vector<int>(columns, -1));
+
+	// First parity column: shifts 1, 0, 1 at the top, middle and bottom rows, then a staircase of identities.
+	shift[0][info] = 1;
+	shift[mid][info] = 0;
+	shift[rows - 1][info] = 1;
+
+	for (int i = 1; i < rows; ++i)
+		shift[i - 1][info + i] = shift[i][info + i] = 0;
+
+	// Two rows meeting in two columns close a 4-cycle when the shifts around it cancel.
+	auto closes_cycle = [&](int r, int c, int s) {
+		for (int r2 = 0; r2 < rows; ++r2) {
+			if (r2 == r || shift[r2][c] < 0)
+				continue;
+
+			for (int c2 = 0; c2 < columns; ++c2) {
+				if (c2 != c && shift[r][c2] >= 0 && shift[r2][c2] >= 0 && (s - shift[r][c2] + shift[r2][c2] - shift[r2][c] + 2 * z) % z == 0)
+					return true;
+			}
+		}
+
+		return false;
+	};
+
+	// Data columns have degree 3. Shifts come from a fixed sequence, skipping any that would close a 4-cycle,
+	// so both ends build the same matrix.
+	uint32_t seed = 1;
+
+	for (int c = 0; c < info; ++c) {
+		for (int k = 0; k < 3; ++k) {
+			int r = (3 * c + k) % rows;
+			seed = seed * 1664525 + 1013904223;
+			int start = (seed >> 16) % z;
+
+			shift[r][c] = start;
+
+			for (int t = 0; t < z; ++t) {
+				if (!closes_cycle(r, c, (start + t) % z)) {
+					shift[r][c] = (start + t) % z;
+					break;
+				}
+			}
+		}
+	}
+
+	layers.assign(rows, {});
+
+	for (int r = 0; r < rows; ++r) {
+		for (int c = 0; c < columns; ++c) {
+			if (shift[r][c] >= 0)
+				layers[r].push_back({ c, shift[r][c] });
+		}
+	}
+}
+
+void ldpc_code::encode(const uint8_t* msg, uint8_t* parity) {
+	int info = columns - rows;
+	int mid = rows / 2;
+	std::vector<uint8_t> bits(data_bits()), lambda(parity_bits(), 0), p(parity_bits(), 0);
+
+	for (size_t b = 0; b < bits.size(); ++b)
+		bits[b] = (msg[b / 8] >> (7 - b % 8)) & 1;
+
+	for (int r = 0; r < rows; ++r) {
+		for (auto& e : layers[r]) {
+			if (e.column >= info)
+				continue;
+
+			for (int i = 0; i < z; ++i)
+				lambda[r * z + i] ^= bits[e.column * z + (i + e.shift) % z];
+		}
+	}
+
+	// Summing every row cancels the staircase and two of the three entries in the first parity column,
+	// which leaves that column on its own. Each row then yields the next staircase column.
+	for (int r = 0; r < rows; ++r) {
+		for (int i = 0; i < z; ++i)
+			p[i] ^= lambda[r * z + i];
+	}
+
+	for (int i = 0; i < z; ++i)
+		p[z + i] = lambda[i] ^ p[(i + 1) % z];
+
+	for (int r = 1; r + 1 < rows; ++r) {
+		for (int i = 0; i < z; ++i)
+			p[(r + 1) * z + i] = lambda[r * z + i] ^ p[r * z + i] ^ (r == mid ? p[i] : 0);
+	}
+
+	memset(parity, 0, parity_bits() / 8);
+
+	for (size_t b = 0; b < p.size(); ++b)
+		parity[b / 8] |= p[b] << (7 - b % 8);
+}
+
+bool ldpc_code::satisfied() {
+	for (auto& layer : layers) {
+		int16_t* acc = extrinsic.data();
+		memset(acc, 0, z * sizeof(int16_t));
+
+		for (auto& e : layer) {
+			const int16_t* col = app.data() + e.column * z;
+
+			for (int i = 0; i < z - e.shift; ++i)
+				acc[i] ^= col[i + e.shift];
+
+			for (int i = z - e.shift; i < z; ++i)
+				acc[i] ^= col[i + e.shift - z];
+		}
+
+		for (int i = 0; i < z; ++i) {
+			if (acc[i] < 0)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+bool ldpc_code::decode(const int8_t* llr, uint8_t* dst, int iterations) {
+	const __m128i zero = _mm_setzero_si128(), top = _mm_set1_epi16(INT16_MAX);
+
+	// Inside the decoder a positive value leans toward 0, as min-sum is usually written.
+	for (size_t b = 0; b < app.size(); ++b)
+		app[b] = -llr[b];
+
+	std::fill(messages.begin(), messages.end(), 0);
+
+	bool ok = satisfied();
+
+	// Layered normalized min-sum. The z checks of one base row never share a bit, so they run eight to a register
+	// once each neighbouring column is rotated by its shift.
+	for (int it = 0; it < iterations && !ok; ++it) {
+		int16_t* m = messages.data();
+
+		for (auto& layer : layers) {
+			int degree = (int)layer.size();
+
+			for (int k = 0; k < degree; ++k) {
+				const int16_t* col = app.data() + layer[k].column * z;
+				int s = layer[k].shift;
+				int16_t* q = extrinsic.data() + k * z;
+
+				memcpy(rotated.data(), col + s, (z - s) * sizeof(int16_t));
+				memcpy(rotated.data() + z - s, col, s * sizeof(int16_t));
+
+				for (int i = 0; i < z; i += 8) {
+					__m128i a = _mm_loadu_si128((const __m128i*)(rotated.data() + i));
+					__m128i r = _mm_loadu_si128((const __m128i*)(m + k * z + i));
+					_mm_storeu_si128((__m128i*)(q + i), _mm_subs_epi16(a, r));
+				}
+			}
+
+			for (int i = 0; i < z; i += 8) {
+				__m128i min1 = top, min2 = top, index = zero, sign = zero;
+
+				for (int k = 0; k < degree; ++k) {
+					__m128i q = _mm_loadu_si128((const __m128i*)(extrinsic.data() + k * z + i));
+					__m128i a = _mm_max_epi16(q, _mm_subs_epi16(zero, q));
+					__m128i smaller = _mm_cmpgt_epi16(min1, a);
+
+					min2 = _mm_min_epi16(min2, _mm_max_epi16(min1, a));
+					index = _mm_or_si128(_mm_and_si128(smaller, _mm_set1_epi16(k)), _mm_andnot_si128(smaller, index));
+					min1 = _mm_min_epi16(min1, a);
+					sign = _mm_xor_si128(sign, q);
+				}
+
+				min1 = _mm_subs_epi16(min1, _mm_srai_epi16(min1, 2));
+				min2 = _mm_subs_epi16(min2, _mm_srai_epi16(min2, 2));
+
+				for (int k = 0; k < degree; ++k) {
+					__m128i* qp = (__m128i*)(extrinsic.data() + k * z + i);
+					__m128i q = _mm_loadu_si128(qp);
+					__m128i own = _mm_cmpeq_epi16(index, _mm_set1_epi16(k));
+					__m128i mag = _mm_or_si128(_mm_and_si128(own, min2), _mm_andnot_si128(own, min1));
+					__m128i mask = _mm_srai_epi16(_mm_xor_si128(sign, q), 15);
+					__m128i r = _mm_sub_epi16(_mm_xor_si128(mag, mask), mask);
+
+					_mm_storeu_si128((__m128i*)(m + k * z + i), r);
+					_mm_storeu_si128(qp, _mm_adds_epi16(q, r));
+				}
+			}
+
+			for (int k = 0; k < degree; ++k) {
+				int16_t* col = app.data() + layer[k].column * z;
+				int s = layer[k].shift;
+				const int16_t* q = extrinsic.data() + k * z;
+
+				memcpy(col + s, q, (z - s) * sizeof(int16_t));
+				memcpy(col, q + z - s, s * sizeof(int16_t));
+			}
+
+			m += degree * z;
+		}
+
+		ok = satisfied();
+	}
+
+	memset(dst, 0, block_bits() / 8);
+
+	for (size_t b = 0; b < app.size(); ++b)
+		dst[b / 8] |= (app[b] < 0) << (7 - b % 8);
+
+	return ok;
+}
\ No newline at end of file
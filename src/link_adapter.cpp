@@ -0,0 +1,117 @@
+#include "link_adapter.h"
+#include <cmath>
+#include <cstring>
+
+void build_mode_frame(const mode_header& header, std::vector<char>& dst) {
+	frame_header frame(0, frame_type::mode, 0);
+	size_t idx = dst.size();
+
+	dst.insert(dst.end(), (char*)&frame, (char*)&frame + frame_header_size);
+
+	// The header is tiny, so repeat it over the payload and let the receiver check that the copies agree.
+	for (size_t len = 0; len + sizeof(mode_header) <= frame_payload_size; len += sizeof(mode_header))
+		dst.insert(dst.end(), (char*)&header, (char*)&header + sizeof(mode_header));
+
+	dst.resize(idx + frame_size, 0);
+	seal_frame(dst.data() + idx);
+}
+
+bool parse_mode_frame(const char* frame, mode_header& dst) {
+	if (((frame_header*)frame)->type != (uint8_t)frame_type::mode)
+		return false;
+
+	const char* payload = frame + frame_header_size;
+
+	if (memcmp(payload, payload + sizeof(mode_header), sizeof(mode_header)) != 0)
+		return false;
+
+	memcpy(&dst, payload, sizeof(mode_header));
+
+	for (auto& mode : link_modes) {
+		if ((uint8_t)mode.type == dst.device_type && mode.baud_rate == dst.baud_rate)
+			return dst.frames > 0;
+	}
+
+	return false;
+}
+
+void link_adapter::measure(const std::vector<short>& v, bool in_frame) {
+	if (v.empty())
+		return;
+
+	double power = 0;
+
+	for (short s : v)
+		power += (double)s * s;
+
+	power /= v.size();
+
+	std::lock_guard<std::mutex> lock(m);
+
+	// Idle input sets the noise floor; let it creep up slowly so a long transmission cannot drag it along.
+	if (!in_frame)
+		noise_power = noise_power < 0 ? power : std::min(power, noise_power * 1.02);
+
+	else
+		signal_power = signal_power < 0 ? power : signal_power * 0.8 + power * 0.2;
+}
+
+void link_adapter::frame_received() {
+	std::lock_guard<std::mutex> lock(m);
+	loss *= 0.9;
+}
+
+void link_adapter::frame_lost() {
+	std::lock_guard<std::mutex> lock(m);
+	loss = loss * 0.9 + 0.1;
+}
+
+void link_adapter::feedback(const link_report& report) {
+	if (report.snr == UINT8_MAX)
+		return;
+
+	std::lock_guard<std::mutex> lock(m);
+
+	// Back off as soon as the peer struggles, but only climb after several reports with room to spare.
+	if (report.loss > max_loss * 100 || report.snr < link_modes[level].min_snr) {
+		level = std::max(level - 1, 0);
+		good_reports = 0;
+		return;
+	}
+
+	if (level + 1 < link_mode_count && report.snr >= link_modes[level + 1].min_snr + step_up_margin) {
+		if (++good_reports >= step_up_reports) {
+			level += 1;
+			good_reports = 0;
+		}
+	}
+
+	else
+		good_reports = 0;
+}
+
+link_report link_adapter::report() {
+	std::lock_guard<std::mutex> lock(m);
+
+	if (noise_power < 0 || signal_power < 0)
+		return link_report();
+
+	double snr = 10 * std::log10(std::max(signal_power / std::max(noise_power, 1.0) - 1, 1e-3));
+
+	return link_report((uint8_t)std::min(std::max(snr, 0.0), 254.0), (uint8_t)std::round(loss * 100));
+}
+
+link_mode link_adapter::mode() {
+	std::lock_guard<std::mutex> lock(m);
+	return link_modes[level];
+}
+
+void link_adapter::reset() {
+	std::lock_guard<std::mutex> lock(m);
+
+	level = 0;
+	good_reports = 0;
+	noise_power = -1;
+	signal_power = -1;
+	loss = 0;
+}
\ No newline at end of file
@@ -2,16 +2,26 @@
 #include <QMessageBox>
 #include <QFileDialog>
 #include <QStandardPaths>
+#include <QDateTime>
 #include <bitset>
 #include "info_window.h"
 #include "utils.h"
+#include "delta.h"
+#include "crc32c.h"
+
+static QString received_dir() {
+    return QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation) + "/Audio Modem Received Files/";
+}
 
 main_window::main_window(QWidget *parent)
-    : QWidget(parent), modem(2048, 48000), engine(std::random_device{}())
+    : QWidget(parent), modem(2048, 48000)
 {
     vLayout = new QVBoxLayout(this);
     hLayout = new QHBoxLayout(this);
     actionFile = new QAction("Open File", this);
+    actionUpdate = new QAction("Send File Changes", this);
+    actionBroadcast = new QAction("Broadcast File", this);
+    actionStopBroadcast = new QAction("Stop Broadcast", this);
     actionExport = new QAction("Export Log", this);
     actionStartStream = new QAction("Start Audio Stream", this);
     actionStopStream = new QAction("Stop Audio Stream", this);
@@ -34,6 +44,9 @@ main_window::main_window(QWidget *parent)
 
     menuFile = menuBar->addMenu("File");
     menuFile->addAction(actionFile);
+    menuFile->addAction(actionUpdate);
+    menuFile->addAction(actionBroadcast);
+    menuFile->addAction(actionStopBroadcast);
     menuFile->addAction(actionExport);
     menuModem = menuBar->addMenu("Modem");
     menuModem->addAction(actionStartStream);
@@ -71,6 +84,9 @@ main_window::main_window(QWidget *parent)
     connect(buttonFile, &QPushButton::clicked, this, &main_window::send_file);
     connect(textInput, &MyTextEdit::enter_signal, this, &main_window::send_msg);
     connect(actionFile, &QAction::triggered, this, &main_window::send_file);
+    connect(actionUpdate, &QAction::triggered, this, &main_window::update_file);
+    connect(actionBroadcast, &QAction::triggered, this, &main_window::broadcast_file);
+    connect(actionStopBroadcast, &QAction::triggered, this, &main_window::stop_broadcast);
     connect(actionExport, &QAction::triggered, this, &main_window::export_log);
     connect(actionConfig, &QAction::triggered, this, &main_window::show_config);
     connect(actionStartStream, &QAction::triggered, this, &main_window::start_audio_stream);
@@ -83,6 +99,7 @@ main_window::main_window(QWidget *parent)
     connect(modem.get_signal(), &modem_signal_sender::configuration_changed, this, &main_window::config_changed);
     connect(modem.get_signal(), &modem_signal_sender::packet_receiving, this, &main_window::receiving_packet);
     connect(modem.get_signal(), &modem_signal_sender::packet_lost, this, [=]() { statusBar->showMessage("Packet lost.", 1000); });
+    connect(modem.get_signal(), &modem_signal_sender::packet_sent, this, [=]() { statusBar->showMessage("Transmission completed.", 1000); });
 
     start_audio_stream();
     start_demodulation_service();
@@ -139,59 +156,262 @@ void main_window::send_msg() {
     packet_header header;
     packet p(header, std::move(data));
 
-    std::uniform_int_distribution<int> uni_int(0, UINT8_MAX);
-    p.header()->id = uni_int(engine);
     p.header()->control = packet_control::text;
 
-    modem.modulate(p.packet_data());
+    modem.submit(p.packet_data(), tx_priority::interactive, [this](bool played) { if (played) emit modem.get_signal()->packet_sent(); });
 
     cout << time << " <TX> : " << str.c_str() << "\n";
     textInput->setText("");
 }
 
+bool main_window::read_file(const QString& dir, packet& p) {
+    QFile fp(dir);
+
+    if (!fp.open(QIODeviceBase::ReadOnly)) {
+        cout << "<System> An error occured while opening file.\n";
+        fp.close();
+        return false;
+    }
+
+    packet_header header;
+    file_header f_header(QFileInfo(fp).fileName().toStdString(), fp.size());
+    std::vector<char> meta;
+    size_t file_size = fp.size();
+
+    f_header.modified = std::max<qint64>(QFileInfo(fp).lastModified().toSecsSinceEpoch(), 0);
+    f_header.encode(meta);
+
+    size_t max_file_size = max_data_size - meta.size();
+
+    if (file_size > max_file_size) {
+        cout << "<System> Cannnot exceed " << max_file_size << " Bytes.\n";
+        fp.close();
+        return false;
+    }
+
+    QByteArray&& data = fp.read(file_size);
+
+    p.push(&header, sizeof(header));
+    p.push(meta.data(), meta.size());
+    p.push(data.data(), file_size);
+    p.header()->control = packet_control::file;
+    p.header()->len = p.packet_data().size();
+
+    fp.close();
+
+    return true;
+}
+
 void main_window::send_file() {
     QStringList dirs = QFileDialog::getOpenFileNames(this, "Select Files", QDir::currentPath());
 
     for (auto& dir : dirs) {
-        QFile fp(dir);
+        packet p;
 
-        if (!fp.open(QIODeviceBase::ReadOnly)) {
-            cout << "<System> An error occured while opening file.\n";
-            fp.close();
+        if (!read_file(dir, p))
             break;
-        }
 
-        packet_header header;
-        file_header f_header(QFileInfo(fp).fileName().toStdString(), fp.size());
-        size_t file_size = fp.size();
-        size_t max_file_size = max_data_size - file_header_size;
+        cout << time << " <FILE TX> : Sended " << QFileInfo(dir).fileName() << "\n";
 
-        if (file_size > max_file_size) {
-            cout << "<System> Cannnot exceed " << max_file_size << " Bytes.\n";
-            fp.close();
-            break;
-        }
+        modem.submit(p.packet_data(), tx_priority::bulk, [this](bool played) { if (played) emit modem.get_signal()->packet_sent(); });
+    }
+}
 
-        std::uniform_int_distribution<int> uni_int(0, UINT8_MAX);
-        header.id = uni_int(engine);
+// Offers each file to receivers that may hold an older copy. Whoever has one answers with its block signatures and
+// gets only the changes; with no answer in time, or none worth using, the whole file goes out as usual.
+void main_window::update_file() {
+    QStringList dirs = QFileDialog::getOpenFileNames(this, "Select Files", QDir::currentPath());
 
+    for (auto& dir : dirs) {
         packet p;
-        QByteArray&& data = fp.read(file_size);
+        file_header head;
+
+        if (!read_file(dir, p))
+            break;
+
+        size_t len = head.decode(p.data(), p.size() - header_size);
+        head.hash = crc32c(p.data() + len, head.data_length);
+
+        offers[head.file_name] = p;
+        send_packet(packet_control::file_offer, head, {}, tx_priority::interactive);
+
+        cout << time << " <FILE TX> : Offered " << QFileInfo(dir).fileName() << "\n";
+
+        QTimer::singleShot(offer_timeout_ms, this, [this, name = head.file_name]() {
+            auto found = offers.find(name);
+
+            if (found == offers.end())
+                return;
+
+            cout << time << " <FILE TX> : No copy of " << name << " at the receiver, sending all of it.\n";
+            modem.submit(found->second.packet_data(), tx_priority::bulk, [this](bool played) { if (played) emit modem.get_signal()->packet_sent(); });
+            offers.erase(found);
+        });
+    }
+}
+
+void main_window::send_packet(uint8_t control, const file_header& head, const std::vector<char>& data, tx_priority priority) {
+    packet_header header;
+    std::vector<char> meta;
+    packet p;
+
+    head.encode(meta);
+
+    p.push(&header, sizeof(header));
+    p.push(meta.data(), meta.size());
+    p.push(data.data(), data.size());
+    p.header()->control = control;
+    p.header()->len = p.packet_data().size();
+
+    modem.submit(p.packet_data(), priority, nullptr);
+}
+
+void main_window::answer_offer(const file_header& head) {
+    file_header reply(head.file_name);
+    std::vector<char> signatures;
+    QFile fp(received_dir() + QString::fromStdString(head.file_name));
+
+    // Without a copy the answer is empty, which tells the sender to go ahead with the whole file. A copy that
+    // already matches the offer is named by its hash, and the sender has nothing to send.
+    if (fp.exists() && fp.open(QFile::ReadOnly)) {
+        QByteArray basis = fp.readAll();
+        fp.close();
+
+        reply.data_length = basis.size();
+        reply.hash = crc32c(basis.data(), basis.size());
+
+        if (reply.data_length != head.data_length || reply.hash != head.hash)
+            build_signatures(basis.data(), basis.size(), signatures);
+    }
+
+    send_packet(packet_control::file_signature, reply, signatures, tx_priority::interactive);
+}
+
+void main_window::send_changes(const file_header& head, const char* signatures, size_t sig_size) {
+    auto found = offers.find(head.file_name);
+
+    if (found == offers.end())
+        return;
+
+    packet& file = found->second;
+    file_header offered;
+    const char* data = file.data() + offered.decode(file.data(), file.size() - header_size);
+    size_t size = offered.data_length;
+    std::vector<char> delta;
+
+    if (head.hash && head.data_length == size && head.hash == crc32c(data, size))
+        cout << time << " <FILE TX> : The receiver already has " << head.file_name << "\n";
 
-        p.push(&header, sizeof(header));
-        p.push(&f_header, sizeof(f_header));
-        p.push(data.data(), file_size);
-        p.header()->control = packet_control::file;
-        p.header()->len = p.packet_data().size();
+    else if (sig_size > 0 && build_delta(data, size, signatures, sig_size, delta) && delta.size() < size) {
+        cout << time << " <FILE TX> : Sending " << delta.size() << " of " << size << " Bytes of " << head.file_name << "\n";
+        send_packet(packet_control::file_delta, offered, delta, tx_priority::bulk);
+    }
+
+    else {
+        cout << time << " <FILE TX> : Sended " << head.file_name << "\n";
+        modem.submit(file.packet_data(), tx_priority::bulk, [this](bool played) { if (played) emit modem.get_signal()->packet_sent(); });
+    }
+
+    offers.erase(found);
+}
+
+void main_window::apply_changes(const file_header& head, const char* delta, size_t size) {
+    QFile fp(received_dir() + QString::fromStdString(head.file_name));
+
+    if (!fp.open(QFile::ReadOnly)) {
+        cout << time << " <FILE RX> : No copy of " << head.file_name << " to update.\n";
+        return;
+    }
+
+    QByteArray basis = fp.readAll();
+    std::vector<char> updated;
+    fp.close();
+
+    if (!apply_delta(basis.data(), basis.size(), delta, size, updated)) {
+        cout << time << " <FILE RX> : The changes to " << head.file_name << " do not match our copy.\n";
+        return;
+    }
 
+    if (!fp.open(QFile::WriteOnly | QFile::Truncate)) {
+        cout << time << " <FILE RX> : Failed to write " << head.file_name << "\n";
+        return;
+    }
+
+    fp.write(updated.data(), updated.size());
+
+    if (head.modified)
+        fp.setFileTime(QDateTime::fromSecsSinceEpoch(head.modified), QFileDevice::FileModificationTime);
+
+    fp.close();
+
+    cout << time << " <FILE RX> : Successfully updated " << head.file_name << "\n";
+}
+
+void main_window::save_file(const file_header& head, const char* data) {
+    QFile fp(utils::new_dir(received_dir(), QString::fromStdString(head.file_name)));
+
+    if (!fp.open(QFile::WriteOnly)) {
+        cout << time << " <FILE RX> : Failed to write " << head.file_name << "\n";
         fp.close();
+        return;
+    }
+
+    fp.write(data, head.data_length);
+
+    if (head.modified)
+        fp.setFileTime(QDateTime::fromSecsSinceEpoch(head.modified), QFileDevice::FileModificationTime);
 
-        cout << time << " <FILE TX> : Sended " << QFileInfo(fp).fileName() << "\n";
+    fp.close();
+
+    cout << time << " <FILE RX> : Successfully wrote " << head.file_name << "\n";
+}
+
+void main_window::receive_file(packet* p) {
+    file_header head;
+    size_t len = head.decode(p->data(), p->size() - header_size);
+    const char* data = p->data() + len;
+    size_t size = p->size() - header_size - len;
+
+    if (len == 0 || (p->header()->control == packet_control::file && head.data_length != size)) {
+        cout << time << " <FILE RX> : The file is corrupted.\n";
+        return;
+    }
+
+    switch (p->header()->control) {
+
+    case packet_control::file:
+        save_file(head, data); break;
+
+    case packet_control::file_offer:
+        answer_offer(head); break;
+
+    case packet_control::file_signature:
+        send_changes(head, data, size); break;
+
+    case packet_control::file_delta:
+        apply_changes(head, data, size); break;
 
-        modem.modulate(p.packet_data());
     }
 }
 
+void main_window::broadcast_file() {
+    QString dir = QFileDialog::getOpenFileName(this, "Select File", QDir::currentPath());
+    packet p;
+
+    if (dir.isEmpty() || !read_file(dir, p))
+        return;
+
+    cout << time << " <FILE TX> : Broadcasting " << QFileInfo(dir).fileName() << "\n";
+
+    modem.broadcast(p.packet_data());
+}
+
+void main_window::stop_broadcast() {
+    cout << "<System> Broadcast stopped.\n";
+
+    modem.stop_broadcast();
+}
+
 void main_window::debug() {
     packet* p;
 
@@ -242,30 +462,9 @@ void main_window::translate_packet(packet* p) {
     case packet_control::text:
         cout << time << " <RX> : " << p->data() << "\n"; break;
 
-    case packet_control::file: 
-        file_header* head = (file_header*)p->data();
-        
-        if (head->data_length + file_header_size + header_size != p->size()) {
-            cout << time << " <FILE RX> : The file is corrupted.\n";
-            break;
-        }
-
-        QString path = QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation) + "/Audio Modem Received Files/";
-        QFile fp(utils::new_dir(path, head->file_name));
-
-        if (!fp.open(QFile::WriteOnly)) {
-            cout << time << " <FILE RX> : Failed to write " << head->file_name << "\n";
-            fp.close();
-            break;
-        }
-
-        fp.write(p->data() + sizeof(file_header), head->data_length);
-        fp.close();
+    default:
+        receive_file(p); break;
 
-        cout << time << " <FILE RX> : Successfully wrote " << head->file_name << "\n";
-        
-        break;
-        
     }
     
     delete p;
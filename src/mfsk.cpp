@@ -0,0 +1,214 @@
+#include "mfsk.h"
+#include <cmath>
+#include <bitset>
+
+int mfsk::symbol_size(int sample_rate, int baud_rate, int tones, int spacing, double base_freq) {
+	int bits = 0;
+
+	while ((1 << bits) < tones)
+		bits += 1;
+
+	int n = 32;
+
+	while (n < 8192 && 1.4142 * n * baud_rate < (double)sample_rate * bits)
+		n *= 2;
+
+	while (n < 8192 && (int)std::round(base_freq * n / sample_rate) + (tones - 1) * spacing >= n / 2)
+		n *= 2;
+
+	return n;
+}
+
+mfsk::mfsk(int sample_rate, int baud_rate, int tones, int spacing, double base_freq) : modem_device(sample_rate, baud_rate),
+	tones(tones), spacing(std::max(spacing, 1)), base_freq(base_freq),
+	transform(symbol_size(sample_rate, baud_rate, tones, std::max(spacing, 1), base_freq))
+{
+	samples_per_baud = transform.size();
+	base_bin = std::max(1, (int)std::round(base_freq * samples_per_baud / sample_rate));
+	min_samples = 10 * samples_per_baud;
+	max_volume = 32767;
+	threshold = 0.2;
+	received = 0;
+	bits_per_symbol = 0;
+
+	while ((1 << bits_per_symbol) < tones)
+		bits_per_symbol += 1;
+
+	waves.assign(tones, std::vector<short>(samples_per_baud, 0));
+	gray.assign(tones, 0);
+	symbol_of.assign(tones, 0);
+
+	for (int t = 0; t < tones; ++t) {
+		for (int i = 0; i < samples_per_baud; ++i)
+			waves[t][i] = std::cos(2 * pi * bin(t) * i / samples_per_baud) * max_volume * 0.9;
+
+		gray[t] = t ^ (t >> 1);
+		symbol_of[gray[t]] = t;
+	}
+}
+
+double mfsk::amplitude(std::vector<short>& v, size_t idx, int tone) {
+	double c = 0, s = 0;
+
+	for (int i = 0; i < samples_per_baud; ++i) {
+		double x = (double)v[idx + i] / max_volume;
+		double theta = 2 * pi * bin(tone) * i / samples_per_baud;
+
+		c += std::cos(theta) * x;
+		s += std::sin(theta) * x;
+	}
+
+	return std::sqrt(c * c + s * s) * 2 / samples_per_baud;
+}
+
+int mfsk::detect(std::vector<short>& v, size_t idx, double& power, double& contrast) {
+	re.assign(samples_per_baud, 0);
+	im.assign(samples_per_baud, 0);
+
+	for (int i = 0; i < samples_per_baud; ++i)
+		re[i] = (double)v[idx + i] / max_volume;
+
+	transform.forward(re, im);
+
+	int ret = 0;
+	double second = 0;
+	power = -1;
+
+	for (int t = 0; t < tones; ++t) {
+		int k = bin(t);
+		double val = re[k] * re[k] + im[k] * im[k];
+
+		if (val > power) {
+			second = power;
+			power = val;
+			ret = t;
+		}
+
+		else if (val > second)
+			second = val;
+	}
+
+	contrast = std::sqrt(power / (second + 1e-12));
+	power = std::sqrt(power) * 2 / samples_per_baud;
+	return ret;
+}
+
+int mfsk::sync(std::vector<short>& v) {
+	if (v.size() < min_samples)
+		return -1;
+
+	size_t idx;
+	bool detected = false;
+
+	for (idx = 0; idx + min_samples < v.size(); idx += samples_per_baud) {
+		if (amplitude(v, idx, 0) > threshold) {
+			detected = true;
+			break;
+		}
+	}
+
+	if (!detected) {
+		v.erase(v.begin(), v.begin() + idx);
+		return -1;
+	}
+
+	size_t start = idx;
+	double plateau = amplitude(v, idx + samples_per_baud, 0);
+
+	if (plateau < threshold) {
+		v.erase(v.begin(), v.begin() + idx + samples_per_baud);
+		return -1;
+	}
+
+	for (idx += samples_per_baud; idx + min_samples < v.size(); idx += samples_per_baud / 4) {
+		if (amplitude(v, idx, 0) > plateau / 2)
+			continue;
+
+		size_t from = idx, max_idx = idx;
+		double max_val = -inf;
+
+		for (size_t i = from; i < from + samples_per_baud; ++i) {
+			double val = (amplitude(v, i, tones - 1) + amplitude(v, i + samples_per_baud, tones / 2)) / 2;
+
+			if (val > max_val) {
+				max_val = val;
+				max_idx = i;
+			}
+		}
+
+		if (max_val < threshold / 2) {
+			v.erase(v.begin(), v.begin() + idx);
+			return -1;
+		}
+
+		v.erase(v.begin(), v.begin() + max_idx + 2LL * samples_per_baud);
+		synchronized = true;
+		return 1;
+	}
+
+	v.erase(v.begin(), v.begin() + start);
+	return -1;
+}
+
+int mfsk::demoulate(std::vector<short>& v, std::vector<char>& dst) {
+	double power, contrast;
+	size_t idx;
+
+	for (idx = 0; idx + min_samples < v.size(); idx += samples_per_baud) {
+		int tone = detect(v, idx, power, contrast);
+
+		if (power < threshold / 4 && contrast < 2) {
+			synchronized = false;
+			buff = "";
+			received = 0;
+
+			v.erase(v.begin(), v.begin() + idx + samples_per_baud);
+			return -1;
+		}
+
+		buff += std::bitset<8>(gray[tone]).to_string().substr(8 - bits_per_symbol);
+
+		while (buff.size() >= 8 && received < frame_size) {
+			unsigned char c = std::bitset<8>(buff.substr(0, 8)).to_ulong();
+			dst.push_back(c);
+			buff.erase(0, 8);
+			received += 1;
+		}
+
+		if (received == frame_size) {
+			received = 0;
+			buff = "";
+			synchronized = false;
+			v.erase(v.begin(), v.begin() + idx + samples_per_baud);
+
+			return 1;
+		}
+	}
+
+	v.erase(v.begin(), v.begin() + idx);
+	return 1;
+}
+
+void mfsk::modulate(char* src, size_t size, std::vector<short>& dst) {
+	for (size_t i = 0; i < size; i += frame_size) {
+		size_t bits = std::min((size_t)frame_size, size - i) * 8;
+
+		for (int n = 0; n < 6; ++n)
+			dst.insert(dst.end(), waves[0].begin(), waves[0].end());
+
+		dst.insert(dst.end(), waves[tones - 1].begin(), waves[tones - 1].end());
+		dst.insert(dst.end(), waves[tones / 2].begin(), waves[tones / 2].end());
+
+		for (size_t bit = 0; bit < bits; ) {
+			int value = 0;
+
+			for (int n = 0; n < bits_per_symbol; ++n, ++bit)
+				value = (value << 1) | (bit < bits ? (src[i + bit / 8] >> (7 - bit % 8)) & 1 : 0);
+
+			auto& wave = waves[symbol_of[value]];
+			dst.insert(dst.end(), wave.begin(), wave.end());
+		}
+	}
+
+	dst.insert(dst.end(), waves[0].begin(), waves[0].end());
+}
\ No newline at end of file
@@ -1,6 +1,13 @@
 #include "modem_device.h"
 #include "fsk.h"
 #include "qpsk.h"
+#include "ofdm.h"
+#include "qam.h"
+#include "mfsk.h"
+#include "dpsk.h"
+#include "css.h"
+#include "multi_carrier.h"
+#include "multi_receiver.h"
 
 modem_device* modem_device::new_device(modem_type type, int sample_rate, int baud_rate) {
 	modem_device* ret;
@@ -12,9 +19,56 @@ modem_device* modem_device::new_device(modem_type type, int sample_rate, int bau
 	case modem_type::qpsk:
 		ret = new qpsk(sample_rate, baud_rate); break;
 
+	case modem_type::ofdm:
+		ret = new ofdm(sample_rate, baud_rate); break;
+
+	case modem_type::psk8:
+	case modem_type::qam16:
+		ret = new qam(sample_rate, baud_rate, type); break;
+
+	case modem_type::mfsk:
+		ret = new mfsk(sample_rate, baud_rate); break;
+
+	case modem_type::dbpsk:
+	case modem_type::dqpsk:
+		ret = new dpsk(sample_rate, baud_rate, type); break;
+
+	case modem_type::css:
+		ret = new css(sample_rate, baud_rate); break;
+
+	case modem_type::fsk_multi:
+	case modem_type::qpsk_multi:
+		ret = new multi_carrier(sample_rate, baud_rate, type); break;
+
+	case modem_type::auto_rx:
+		ret = new multi_receiver(sample_rate, baud_rate); break;
+
+	case modem_type::fsk_coded:
+		ret = new fsk(sample_rate, baud_rate, 1, 0.9, true); break;
+
+	case modem_type::qpsk_coded:
+		ret = new qpsk(sample_rate, baud_rate, 1, 0.9, true); break;
+
 	default:
 		ret = NULL;
 	}
 
 	return ret;
+}
+
+// Devices without soft output report every bit as certain.
+int modem_device::demoulate_soft(std::vector<short>& v, std::vector<char>& dst, std::vector<int8_t>& llr) {
+	size_t idx = dst.size();
+	int ret = demoulate(v, dst);
+
+	hard_llr(dst.data() + idx, dst.size() - idx, llr);
+
+	return ret;
+}
+
+void modem_device::hard_llr(const char* src, size_t size, std::vector<int8_t>& dst) {
+	for (size_t i = 0; i < size; ++i) {
+		for (int b = 7; b >= 0; --b)
+			dst.push_back((src[i] >> b) & 1 ? max_llr : -max_llr);
+	}
 }
\ No newline at end of file
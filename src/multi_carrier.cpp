@@ -0,0 +1,125 @@
+#include "multi_carrier.h"
+#include "fsk.h"
+#include "qpsk.h"
+#include <algorithm>
+
+int multi_carrier::max_carriers(int sample_rate, int baud_rate, modem_type type, int first_carrier) {
+	int samples_per_baud = type == modem_type::qpsk_multi ? 2 * sample_rate / baud_rate : sample_rate / baud_rate;
+	int top = (int)(0.4 * samples_per_baud);
+
+	return std::max(1, (top - first_carrier - 1) / 2 + 1);
+}
+
+multi_carrier::multi_carrier(int sample_rate, int baud_rate, modem_type type, int carriers, int first_carrier) : modem_device(sample_rate, baud_rate),
+	m_type(type), m_carriers(carriers), m_first_carrier(std::max(first_carrier, 1))
+{
+	int count = std::min(std::max(carriers, 1), max_carriers(sample_rate, baud_rate, type, m_first_carrier));
+	double volume = 0.9 / count;
+
+	// Sub-carriers sit two harmonics apart, so every lane stays orthogonal to its neighbours over one symbol.
+	for (int i = 0; i < count; ++i) {
+		int carrier = m_first_carrier + 2 * i;
+		modem_device* device;
+
+		if (type == modem_type::qpsk_multi)
+			device = new qpsk(sample_rate, baud_rate, carrier, volume);
+
+		else
+			device = new fsk(sample_rate, baud_rate, carrier, volume);
+
+		lanes.push_back(lane{ device, {}, {} });
+	}
+}
+
+multi_carrier::~multi_carrier() {
+	for (auto& l : lanes)
+		delete l.device;
+}
+
+void multi_carrier::feed(std::vector<short>& v) {
+	for (auto& l : lanes)
+		l.samples.insert(l.samples.end(), v.begin(), v.end());
+
+	v.clear();
+}
+
+int multi_carrier::step(lane& l, std::vector<char>& dst) {
+	int ret = 1;
+
+	// Sub-devices expect fresh samples between sync attempts, so each lane tries to sync at most once per finished frame.
+	while (l.device->is_synchronized() || l.device->sync(l.samples) == 1) {
+		if (l.device->demoulate(l.samples, l.received) == -1) {
+			l.received.clear();
+			ret = -1;
+		}
+
+		size_t whole = l.received.size() / frame_size * frame_size;
+		dst.insert(dst.end(), l.received.begin(), l.received.begin() + whole);
+		l.received.erase(l.received.begin(), l.received.begin() + whole);
+
+		if (l.device->is_synchronized() || ret == -1)
+			break;
+	}
+
+	return ret;
+}
+
+int multi_carrier::sync(std::vector<short>& v) {
+	feed(v);
+
+	for (auto& l : lanes) {
+		if (!l.device->is_synchronized())
+			l.device->sync(l.samples);
+
+		synchronized |= l.device->is_synchronized();
+	}
+
+	return synchronized ? 1 : -1;
+}
+
+int multi_carrier::demoulate(std::vector<short>& v, std::vector<char>& dst) {
+	int ret = 1;
+	feed(v);
+	synchronized = false;
+
+	for (auto& l : lanes) {
+		if (step(l, dst) == -1)
+			ret = -1;
+
+		synchronized |= l.device->is_synchronized();
+	}
+
+	return ret;
+}
+
+void multi_carrier::modulate(char* src, size_t size, std::vector<short>& dst) {
+	size_t count = lanes.size();
+	std::vector<std::vector<char>> striped(count);
+	std::vector<std::vector<short>> outputs(count);
+
+	for (size_t i = 0; i < size; i += frame_size) {
+		auto& lane_src = striped[i / frame_size % count];
+		lane_src.insert(lane_src.end(), src + i, src + std::min(size, i + frame_size));
+	}
+
+	size_t len = 0;
+
+	for (size_t i = 0; i < count; ++i) {
+		if (!striped[i].empty())
+			lanes[i].device->modulate(striped[i], outputs[i]);
+
+		len = std::max(len, outputs[i].size());
+	}
+
+	size_t idx = dst.size();
+	dst.insert(dst.end(), len, 0);
+
+	for (size_t n = 0; n < len; ++n) {
+		int sum = 0;
+
+		for (auto& output : outputs)
+			sum += n < output.size() ? output[n] : 0;
+
+		dst[idx + n] = (short)std::min(std::max(sum, -32767), 32767);
+	}
+}
\ No newline at end of file
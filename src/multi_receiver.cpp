@@ -0,0 +1,192 @@
+#include "multi_receiver.h"
+#include <algorithm>
+
+multi_receiver::multi_receiver(int sample_rate, int baud_rate, const std::vector<receiver_hypothesis>& hypotheses) : modem_device(sample_rate, baud_rate),
+	m_hypotheses(hypotheses), active(NULL), stop(false), tolerance(0), m_fec(fec_scheme::none)
+{
+	// The configured baud comes first so that it is also what this end transmits with.
+	std::vector<receiver_hypothesis> list = hypotheses;
+
+	if (list.empty()) {
+		list = {
+			{ modem_type::fsk, baud_rate },
+			{ modem_type::qpsk, baud_rate },
+			{ modem_type::fsk, 600 },
+			{ modem_type::fsk, 1225 },
+			{ modem_type::qpsk, 1225 },
+			{ modem_type::qpsk, 2400 },
+			{ modem_type::dqpsk, 1225 }
+		};
+	}
+
+	for (size_t i = 0; i < list.size(); ++i) {
+		auto same = [&](const receiver_hypothesis& h) { return h.type == list[i].type && h.baud_rate == list[i].baud_rate; };
+
+		if (std::find_if(list.begin(), list.begin() + i, same) != list.begin() + i)
+			continue;
+
+		modem_device* device = modem_device::new_device(list[i].type, sample_rate, list[i].baud_rate);
+
+		if (!device)
+			continue;
+
+		lanes.push_back(new lane{ device, {}, {}, {}, {}, {} });
+	}
+
+	if (lanes.empty())
+		lanes.push_back(new lane{ modem_device::new_device(modem_type::fsk, sample_rate, baud_rate), {}, {}, {}, {}, {} });
+
+	for (auto l : lanes)
+		l->worker = std::thread(&multi_receiver::run, this, l);
+
+	// Lanes acquire on their own, so the caller should always hand samples straight to demoulate.
+	synchronized = true;
+}
+
+multi_receiver::~multi_receiver() {
+	m.lock();
+	stop = true;
+	m.unlock();
+
+	cv.notify_all();
+
+	for (auto l : lanes) {
+		l->worker.join();
+		delete l->device;
+		delete l;
+	}
+}
+
+void multi_receiver::run(lane* l) {
+	std::vector<short> samples;
+	std::vector<char> received;
+	std::vector<int8_t> llr;
+	std::unique_lock<std::mutex> lock(m);
+	int applied = 0;
+
+	while (true) {
+		cv.wait(lock, [&]() { return stop || !l->input.empty(); });
+
+		if (stop)
+			break;
+
+		samples.insert(samples.end(), l->input.begin(), l->input.end());
+		l->input.clear();
+
+		if (samples.size() < min_block)
+			continue;
+
+		// Settings reach the lane device here, since only this thread touches it.
+		if (applied != tolerance)
+			l->device->set_burst_tolerance(applied = tolerance);
+
+		fec_scheme scheme = m_fec;
+		lock.unlock();
+
+		// Same pacing as a single device: one sync attempt per block, and another only right after a finished frame.
+		modem_device* device = l->device;
+		std::vector<char> frames;
+		std::vector<int8_t> frames_llr;
+		std::vector<bool> passed;
+
+		while (device->is_synchronized() || device->sync(samples) == 1) {
+			int ret = device->demoulate_soft(samples, received, llr);
+			size_t whole = received.size() / frame_size * frame_size;
+
+			// Only a frame that checks out shows that this lane has the right modem; the check runs on a copy, so
+			// the caller still gets the frame as received and decodes it its own way.
+			for (size_t i = 0; i < whole; i += frame_size) {
+				std::vector<char> frame(received.begin() + i, received.begin() + i + frame_size);
+				const int8_t* bits = llr.size() >= (i + frame_size) * 8 ? llr.data() + i * 8 : nullptr;
+
+				passed.push_back(scheme != fec_scheme::none ? repair_frame(frame.data(), bits, scheme) : frame_intact(frame.data()));
+			}
+
+			llr.resize(received.size() * 8, 0);
+			frames.insert(frames.end(), received.begin(), received.begin() + whole);
+			frames_llr.insert(frames_llr.end(), llr.begin(), llr.begin() + whole * 8);
+			received.erase(received.begin(), received.begin() + whole);
+			llr.erase(llr.begin(), llr.begin() + whole * 8);
+
+			if (ret == -1) {
+				received.clear();
+				llr.clear();
+			}
+
+			if (device->is_synchronized() || ret == -1)
+				break;
+		}
+
+		lock.lock();
+		l->output.insert(l->output.end(), frames.begin(), frames.end());
+		l->output_llr.insert(l->output_llr.end(), frames_llr.begin(), frames_llr.end());
+		l->passed.insert(l->passed.end(), passed.begin(), passed.end());
+	}
+}
+
+int multi_receiver::sync(std::vector<short>& v) {
+	std::vector<char> dst;
+	return demoulate(v, dst);
+}
+
+int multi_receiver::demoulate(std::vector<short>& v, std::vector<char>& dst) {
+	std::vector<int8_t> llr;
+	return demoulate_soft(v, dst, llr);
+}
+
+int multi_receiver::demoulate_soft(std::vector<short>& v, std::vector<char>& dst, std::vector<int8_t>& llr) {
+	{
+		std::lock_guard<std::mutex> lock(m);
+
+		// A lane whose frame checks out becomes the active one. Its failed frames are passed on too, still soft, so
+		// a retransmission can be combined with them; failures from the other lanes are only noise read the wrong way.
+		// Another lane may decode the same frame a little later, so skip repeats.
+		for (auto l : lanes) {
+			l->input.insert(l->input.end(), v.begin(), v.end());
+
+			for (size_t i = 0, k = 0; i < l->output.size(); i += frame_size, ++k) {
+				std::vector<char> frame(l->output.begin() + i, l->output.begin() + i + frame_size);
+
+				if (l->passed[k])
+					active = l;
+
+				if (l != active || (l->passed[k] && std::find(recent.begin(), recent.end(), frame) != recent.end()))
+					continue;
+
+				dst.insert(dst.end(), frame.begin(), frame.end());
+				llr.insert(llr.end(), l->output_llr.begin() + i * 8, l->output_llr.begin() + (i + frame_size) * 8);
+
+				if (!l->passed[k])
+					continue;
+
+				recent.push_back(std::move(frame));
+
+				if (recent.size() > max_recent)
+					recent.pop_front();
+			}
+
+			l->output.clear();
+			l->output_llr.clear();
+			l->passed.clear();
+		}
+	}
+
+	v.clear();
+	cv.notify_all();
+
+	return 1;
+}
+
+void multi_receiver::set_burst_tolerance(int symbols) {
+	std::lock_guard<std::mutex> lock(m);
+	tolerance = symbols;
+}
+
+void multi_receiver::set_fec(fec_scheme scheme) {
+	std::lock_guard<std::mutex> lock(m);
+	m_fec = scheme;
+}
+
+void multi_receiver::modulate(char* src, size_t size, std::vector<short>& dst) {
+	lanes[0]->device->modulate(src, size, dst);
+}
\ No newline at end of file
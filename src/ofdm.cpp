@@ -0,0 +1,293 @@
+#include "ofdm.h"
+#include <cmath>
+#include <bitset>
+
+int ofdm::default_fft_size(int sample_rate, int baud_rate) {
+	double target = 16.0 * sample_rate / baud_rate;
+	int n = 64;
+
+	while (n < 4096 && n * 1.4142 < target)
+		n *= 2;
+
+	return n;
+}
+
+ofdm::ofdm(int sample_rate, int baud_rate, int fft_size, int cyclic_prefix, double low_freq, double high_freq, int pilot_spacing)
+	: modem_device(sample_rate, baud_rate), requested_fft_size(fft_size), requested_prefix(cyclic_prefix),
+	fft_size(radix2_fft::is_power_of_two(fft_size) ? fft_size : default_fft_size(sample_rate, baud_rate)),
+	cyclic_prefix(cyclic_prefix > 0 ? cyclic_prefix : this->fft_size / 4),
+	pilot_spacing(std::max(pilot_spacing, 2)), low_freq(low_freq), high_freq(high_freq), transform(this->fft_size)
+{
+	symbol_len = this->fft_size + this->cyclic_prefix;
+	backoff = this->cyclic_prefix / 8;
+	min_samples = 4 * symbol_len;
+	max_volume = INT16_MAX;
+	threshold = 0.1;
+	received = 0;
+
+	double spacing = (double)sample_rate / this->fft_size;
+	int lo = std::max(1, (int)std::ceil(low_freq / spacing));
+	int hi = std::min(this->fft_size / 2 - 1, (int)std::floor(high_freq / spacing));
+
+	hi -= (hi - lo) % this->pilot_spacing;
+
+	for (int k = lo; k <= hi; ++k) {
+		carriers.push_back(k);
+		is_pilot.push_back((k - lo) % this->pilot_spacing == 0);
+	}
+
+	uint32_t seed = 0x2545F491;
+	auto next = [&seed]() { seed = seed * 1664525 + 1013904223; return (seed >> 16) & 1; };
+
+	preamble_re.assign(carriers.size(), 0);
+	preamble_im.assign(carriers.size(), 0);
+	pilot_value.assign(carriers.size(), 0);
+
+	for (int i = 0; i < carriers.size(); ++i) {
+		preamble_re[i] = next() ? sqr : -sqr;
+		preamble_im[i] = next() ? sqr : -sqr;
+		pilot_value[i] = next() ? 1 : -1;
+	}
+
+	scale = 0.25 * max_volume * this->fft_size / std::sqrt(2.0 * carriers.size());
+
+	std::vector<double> x_re(preamble_re), x_im(preamble_im);
+	write(x_re, x_im, preamble);
+
+	channel_re.assign(carriers.size(), 0);
+	channel_im.assign(carriers.size(), 0);
+}
+
+int ofdm::bits_per_symbol() {
+	int data_carriers = 0;
+
+	for (int i = 0; i < carriers.size(); ++i) {
+		if (!is_pilot[i])
+			data_carriers += 1;
+	}
+
+	return 2 * data_carriers;
+}
+
+void ofdm::write(std::vector<double>& x_re, std::vector<double>& x_im, std::vector<short>& dst) {
+	re.assign(fft_size, 0);
+	im.assign(fft_size, 0);
+
+	for (int i = 0; i < carriers.size(); ++i) {
+		int k = carriers[i];
+
+		re[k] = x_re[i];
+		im[k] = x_im[i];
+		re[fft_size - k] = x_re[i];
+		im[fft_size - k] = -x_im[i];
+	}
+
+	transform.inverse(re, im);
+
+	size_t idx = dst.size();
+	dst.insert(dst.end(), symbol_len, 0);
+
+	for (int i = 0; i < symbol_len; ++i) {
+		double x = re[(i + fft_size - cyclic_prefix) % fft_size] * scale;
+		x = std::max(-0.9 * max_volume, std::min(0.9 * max_volume, x));
+
+		dst[idx + i] = (short)x;
+	}
+}
+
+void ofdm::spectrum(std::vector<short>& v, size_t idx) {
+	re.assign(fft_size, 0);
+	im.assign(fft_size, 0);
+
+	size_t start = idx + cyclic_prefix - backoff;
+
+	for (int i = 0; i < fft_size; ++i)
+		re[i] = (double)v[start + i] / max_volume;
+
+	transform.forward(re, im);
+}
+
+int ofdm::sync(std::vector<short>& v) {
+	if (v.size() < min_samples)
+		return -1;
+
+	size_t idx;
+	int window = fft_size / 2;
+	bool detected = false;
+
+	for (idx = 0; idx + min_samples < v.size(); idx += window) {
+		double power = 0;
+
+		for (int i = 0; i < window; ++i) {
+			double x = (double)v[idx + i] / max_volume;
+			power += x * x;
+		}
+
+		if (std::sqrt(power / window) > threshold) {
+			detected = true;
+			break;
+		}
+	}
+
+	if (!detected) {
+		v.erase(v.begin(), v.begin() + idx);
+		return -1;
+	}
+
+	size_t from = idx >= symbol_len ? idx - symbol_len : 0;
+	size_t to = idx + window;
+	size_t max_idx = from;
+	double max_val = -inf;
+	double preamble_energy = 0, energy = 0;
+
+	for (int i = 0; i < symbol_len; ++i) {
+		preamble_energy += (double)preamble[i] * preamble[i];
+		energy += (double)v[from + i] * v[from + i];
+	}
+
+	for (size_t i = from; i <= to; ++i) {
+		double corr = 0;
+
+		for (int j = 0; j < symbol_len; ++j)
+			corr += (double)preamble[j] * v[i + j];
+
+		double val = corr / std::sqrt(preamble_energy * energy + 1);
+
+		if (val > max_val) {
+			max_val = val;
+			max_idx = i;
+		}
+
+		energy += (double)v[i + symbol_len] * v[i + symbol_len] - (double)v[i] * v[i];
+	}
+
+	if (max_val < 0.5) {
+		v.erase(v.begin(), v.begin() + to);
+		return -1;
+	}
+
+	spectrum(v, max_idx);
+
+	for (int i = 0; i < carriers.size(); ++i) {
+		int k = carriers[i];
+
+		channel_re[i] = re[k] * preamble_re[i] + im[k] * preamble_im[i];
+		channel_im[i] = im[k] * preamble_re[i] - re[k] * preamble_im[i];
+	}
+
+	v.erase(v.begin(), v.begin() + max_idx + symbol_len);
+
+	buff = "";
+	received = 0;
+	synchronized = true;
+
+	return 1;
+}
+
+int ofdm::demoulate(std::vector<short>& v, std::vector<char>& dst) {
+	size_t idx;
+	std::vector<double> c_re(carriers.size()), c_im(carriers.size());
+
+	for (idx = 0; idx + min_samples < v.size(); idx += symbol_len) {
+		spectrum(v, idx);
+
+		double power = 0;
+		int pilots = 0;
+
+		for (int i = 0; i < carriers.size(); i += pilot_spacing) {
+			int k = carriers[i];
+			double h_re = channel_re[i] * pilot_value[i];
+			double h_im = channel_im[i] * pilot_value[i];
+			double h_abs = h_re * h_re + h_im * h_im + 1e-12;
+
+			c_re[i] = (re[k] * h_re + im[k] * h_im) / h_abs;
+			c_im[i] = (im[k] * h_re - re[k] * h_im) / h_abs;
+
+			power += std::sqrt(c_re[i] * c_re[i] + c_im[i] * c_im[i]);
+			pilots += 1;
+		}
+
+		if (power / pilots < 0.3) {
+			synchronized = false;
+			buff = "";
+			received = 0;
+
+			v.erase(v.begin(), v.begin() + idx + symbol_len);
+			return -1;
+		}
+
+		for (int i = 0; i < carriers.size(); ++i) {
+			if (is_pilot[i])
+				continue;
+
+			int k = carriers[i];
+			int p = i - i % pilot_spacing;
+			double t = (double)(i - p) / pilot_spacing;
+
+			double g_re = (1 - t) * c_re[p] + t * c_re[p + pilot_spacing];
+			double g_im = (1 - t) * c_im[p] + t * c_im[p + pilot_spacing];
+			double h_re = channel_re[i] * g_re - channel_im[i] * g_im;
+			double h_im = channel_re[i] * g_im + channel_im[i] * g_re;
+
+			double cos = re[k] * h_re + im[k] * h_im;
+			double sin = im[k] * h_re - re[k] * h_im;
+
+			buff += cos > 0 ? '1' : '0';
+			buff += sin > 0 ? '1' : '0';
+
+			if (buff.size() == 8) {
+				unsigned char c = std::bitset<8>(buff).to_ulong();
+				dst.push_back(c);
+				buff = "";
+				received += 1;
+			}
+
+			if (received == frame_size)
+				break;
+		}
+
+
+		if (received == frame_size) {
+			received = 0;
+			buff = "";
+			synchronized = false;
+			v.erase(v.begin(), v.begin() + idx + symbol_len - cyclic_prefix / 2);
+
+			return 1;
+		}
+	}
+
+	v.erase(v.begin(), v.begin() + idx);
+	return 1;
+}
+
+void ofdm::modulate(char* src, size_t size, std::vector<short>& dst) {
+	std::vector<double> x_re(carriers.size()), x_im(carriers.size());
+
+	for (size_t i = 0; i < size; i += frame_size) {
+		size_t len = std::min((size_t)frame_size, size - i);
+		size_t bits = len * 8, bit = 0;
+
+		dst.insert(dst.end(), preamble.begin(), preamble.end());
+
+		while (bit < bits) {
+			for (int j = 0; j < carriers.size(); ++j) {
+				if (is_pilot[j]) {
+					x_re[j] = pilot_value[j];
+					x_im[j] = 0;
+					continue;
+				}
+
+				bool b[2];
+
+				for (int n = 0; n < 2; ++n, ++bit)
+					b[n] = bit < bits ? (src[i + bit / 8] >> (7 - bit % 8)) & 1 : 0;
+
+				x_re[j] = b[0] ? sqr : -sqr;
+				x_im[j] = b[1] ? sqr : -sqr;
+			}
+
+			write(x_re, x_im, dst);
+		}
+	}
+}
\ No newline at end of file
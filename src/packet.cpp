@@ -1,4 +1,10 @@
 #include "packet.h"
+#include "crc32c.h"
+#include "varint.h"
+#include <cstddef>
+#include <cstring>
+#include <cctype>
+#include <algorithm>
 #include <fstream>
 #include <random>
 
@@ -7,29 +13,13 @@ packet::packet(packet_header& header, const std::vector<char>& data) {
 	this->m_data.insert(this->m_data.end(), data.begin(), data.end());
 
 	this->header()->len = this->m_data.size();
-	this->header()->checksum = this->checksum();
+	seal(this->m_data);
 }
 
 void packet::push(const void* src, size_t size) {
 	m_data.insert(m_data.end(), (char*)src, (char*)src + size);
 }
 
-void packet::push(std::vector<char>& v) {
-	if (m_data.size() == 0) {
-		if (v.size() < header_size)
-			return;
-
-		else {
-			m_data.insert(m_data.end(), v.begin(), v.begin() + header_size);
-			v.erase(v.begin(), v.begin() + header_size);
-		}
-	}
-
-	size_t size_to_push = std::min(v.size(), m_data.size() - (size_t)header()->len);
-	m_data.insert(m_data.end(), v.begin(), v.begin() + size_to_push);
-	v.erase(v.begin(), v.begin() + size_to_push);
-}
-
 bool packet::finished() {
 	if (m_data.size() == 0)
 		return false;
@@ -39,7 +29,7 @@ bool packet::finished() {
 }
 
 bool packet::valid() {
-	if (m_data.size() == 0)
+	if (!finished())
 		return false;
 
 	else
@@ -53,31 +43,117 @@ packet_header* packet::header() {
 	return (packet_header*)(m_data.data());
 }
 
-uint16_t packet::checksum() {
+uint32_t packet::checksum() {
 	if (!finished())
 		return 0;
 
-	uint16_t ret = 0;
-	uint16_t tmp;
-	uint16_t old = header()->checksum;
-	header()->checksum = 0;
+	return checksum(m_data);
+}
+
+uint32_t packet::checksum(const std::vector<char>& data) {
+	if (data.size() < header_size)
+		return 0;
+
+	// The checksum field is the last one in the header, so cover everything around it.
+	uint32_t ret = crc32c(data.data(), offsetof(packet_header, checksum));
+
+	return crc32c(data.data() + header_size, data.size() - header_size, ret);
+}
+
+void file_header::encode(std::vector<char>& dst) const {
+	size_t name_length = std::min(file_name.size(), MAX_FILENAME_LEN);
+
+	put_varint(name_length, dst);
+	dst.insert(dst.end(), file_name.begin(), file_name.begin() + name_length);
+	put_varint(data_length, dst);
 
-	for (int i = 0; i < m_data.size() / 2; ++i) {
-		tmp = ((uint16_t*)m_data.data())[i];
-		ret += tmp;
-		if (ret < tmp)
-			ret += 1;
+	if (modified) {
+		dst.push_back(tag_modified);
+		put_varint(modified, dst);
 	}
 
-	if (m_data.size() % 2 != 0) {
-		ret += m_data[m_data.size() - 1];
-		if (ret < m_data[m_data.size() - 1])
-			ret += 1;
+	if (hash) {
+		dst.push_back(tag_hash);
+		put_varint(hash, dst);
 	}
 
-	ret = ~ret;
-	header()->checksum = old;
-	return ret;
+	dst.push_back(tag_end);
+}
+
+size_t file_header::decode(const char* src, size_t size) {
+	const char* p = src, * end = src + size;
+	size_t name_length;
+
+	if (!get_varint(p, end, name_length) || name_length > MAX_FILENAME_LEN || name_length > (size_t)(end - p))
+		return 0;
+
+	file_name.assign(p, name_length);
+	p += name_length;
+	modified = 0;
+	hash = 0;
+
+	if (!get_varint(p, end, data_length))
+		return 0;
+
+	for (;;) {
+		uint64_t value;
+
+		if (p == end)
+			return 0;
+
+		uint8_t tag = *p++;
+
+		if (tag == tag_end)
+			break;
+
+		if (!get_varint(p, end, value))
+			return 0;
+
+		if (tag == tag_modified)
+			modified = value;
+
+		else if (tag == tag_hash)
+			hash = (uint32_t)value;
+	}
+
+	if (!safe_name(file_name))
+		return 0;
+
+	return p - src;
+}
+
+// The name is used as a path under the receive folder, so it must not lead out of it, be cut short, or name a device.
+bool file_header::safe_name(const std::string& name) {
+	static const char* const reserved[] = { "CON", "PRN", "AUX", "NUL" };
+
+	if (name.find_first_not_of(".") == std::string::npos)
+		return false;
+
+	for (char c : name)
+		if ((unsigned char)c < 0x20 || strchr("/\\:*?\"<>|", c))
+			return false;
+
+	// Windows opens the device for these in any case, with any extension and with trailing spaces.
+	std::string stem = name.substr(0, name.find('.'));
+	stem.erase(stem.find_last_not_of(' ') + 1);
+	std::transform(stem.begin(), stem.end(), stem.begin(), [](unsigned char c) { return (char)toupper(c); });
+
+	for (const char* r : reserved)
+		if (stem == r)
+			return false;
+
+	if (stem.size() == 4 && (stem.compare(0, 3, "COM") == 0 || stem.compare(0, 3, "LPT") == 0) && stem[3] >= '1' && stem[3] <= '9')
+		return false;
+
+	return true;
+}
+
+// Fills in the checksum once the packet is final.
+void packet::seal(std::vector<char>& data) {
+	if (data.size() < header_size)
+		return;
+
+	((packet_header*)data.data())->checksum = checksum(data);
 }
 
 packet& packet::operator=(const packet& p) {
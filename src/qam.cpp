@@ -0,0 +1,194 @@
+#include "qam.h"
+
+#include <cmath>
+#include <bitset>
+
+qam::qam(int sample_rate, int baud_rate, modem_type type) : modem_device(sample_rate, baud_rate), m_type(type), acquire(sample_rate, baud_rate) {
+	samples_per_baud = 2 * sample_rate / baud_rate;
+	min_samples = 20 * samples_per_baud;
+	max_volume = INT16_MAX;
+	received = 0;
+	ref_cos = 1;
+	ref_sin = 0;
+
+	_cos.assign(samples_per_baud, 0);
+	_sin.assign(samples_per_baud, 0);
+
+	for (int i = 0; i < samples_per_baud; ++i) {
+		double theta = 2 * pi * i / samples_per_baud;
+		_cos[i] = std::cos(theta);
+		_sin[i] = std::sin(theta);
+	}
+
+	if (m_type == modem_type::psk8) {
+		bits_per_symbol = 3;
+		min_power = 0.5;
+
+		for (int i = 0; i < 8; ++i) {
+			point_cos.push_back(std::cos(pi * i / 4));
+			point_sin.push_back(std::sin(pi * i / 4));
+			gray.push_back(i ^ (i >> 1));
+		}
+	}
+
+	else {
+		const double level[4] = { -3, -1, 3, 1 };
+		double unit = 1 / (3 * std::sqrt(2.0));
+
+		bits_per_symbol = 4;
+		min_power = 0.15;
+
+		for (int i = 0; i < 16; ++i) {
+			point_cos.push_back(level[i >> 2] * unit);
+			point_sin.push_back(level[i & 3] * unit);
+			gray.push_back(i);
+		}
+	}
+}
+
+void qam::phase(std::vector<short>& v, size_t idx, double& cos, double& sin, size_t len) {
+	cos = 0, sin = 0;
+
+	if (len == 0)
+		len = samples_per_baud;
+
+	for (int i = 0; i < len; ++i) {
+		double x = (double)v[idx + i] / max_volume;
+		int t = i % samples_per_baud;
+
+		cos += _cos[t] * x;
+		sin -= _sin[t] * x;
+	}
+
+	cos = cos * 2 / len;
+	sin = sin * 2 / len;
+}
+
+void qam::normalize(double& cos, double& sin) {
+	double power = ref_cos * ref_cos + ref_sin * ref_sin;
+	double c = (cos * ref_cos + sin * ref_sin) / power;
+	double s = (sin * ref_cos - cos * ref_sin) / power;
+
+	cos = c;
+	sin = s;
+}
+
+int qam::decide(double cos, double sin) {
+	int ret = 0;
+	double min_dist = inf;
+
+	for (int i = 0; i < point_cos.size(); ++i) {
+		double dc = cos - point_cos[i];
+		double ds = sin - point_sin[i];
+		double dist = dc * dc + ds * ds;
+
+		if (dist < min_dist) {
+			min_dist = dist;
+			ret = i;
+		}
+	}
+
+	return ret;
+}
+
+int qam::sync(std::vector<short>& v) {
+	if (acquire.sync(v) != 1)
+		return -1;
+
+	// Gain and phase of the reference symbols scale every point that follows.
+	acquire.preamble(ref_cos, ref_sin);
+	synchronized = true;
+
+	return 1;
+}
+
+int qam::demoulate(std::vector<short>& v, std::vector<char>& dst) {
+	double cos, sin;
+	size_t idx;
+
+	for (idx = 0; idx + min_samples < v.size(); idx += samples_per_baud) {
+		phase(v, idx, cos, sin);
+		normalize(cos, sin);
+		double power = std::sqrt(cos * cos + sin * sin);
+
+		if (power < min_power) {
+			synchronized = false;
+			buff = "";
+			received = 0;
+
+			v.erase(v.begin(), v.begin() + idx + samples_per_baud);
+			return -1;
+		}
+
+		int symbol = decide(cos, sin);
+
+		// Decision-directed tracking keeps the reference aligned with slow phase drift.
+		double err = std::atan2(sin * point_cos[symbol] - cos * point_sin[symbol], cos * point_cos[symbol] + sin * point_sin[symbol]);
+		double c = std::cos(0.05 * err), s = std::sin(0.05 * err);
+		double r = ref_cos * c - ref_sin * s;
+		ref_sin = ref_cos * s + ref_sin * c;
+		ref_cos = r;
+
+		buff += std::bitset<4>(gray[symbol]).to_string().substr(4 - bits_per_symbol);
+
+		while (buff.size() >= 8 && received < frame_size) {
+			unsigned char ch = std::bitset<8>(buff.substr(0, 8)).to_ulong();
+			dst.push_back(ch);
+			buff.erase(0, 8);
+			received += 1;
+		}
+
+		if (received == frame_size) {
+			received = 0;
+			buff = "";
+			synchronized = false;
+			v.erase(v.begin(), v.begin() + idx + samples_per_baud);
+
+			return 1;
+		}
+	}
+
+	v.erase(v.begin(), v.begin() + idx);
+	return 1;
+}
+
+void qam::modulate(char* src, size_t size, std::vector<short>& dst) {
+	std::vector<int> symbol_of(gray.size());
+
+	for (int i = 0; i < gray.size(); ++i)
+		symbol_of[gray[i]] = i;
+
+	for (size_t i = 0; i < size; i += frame_size) {
+		size_t bits = std::min((size_t)frame_size, size - i) * 8;
+
+		write(1, 0, dst);
+		write(1, 0, dst);
+		write(1, 0, dst);
+		write(1, 0, dst);
+		write(1, 0, dst);
+		write(1, 0, dst);
+		write(-sqr, -sqr, dst);
+
+		for (size_t bit = 0; bit < bits; ) {
+			int value = 0;
+
+			for (int n = 0; n < bits_per_symbol; ++n, ++bit)
+				value = (value << 1) | (bit < bits ? (src[i + bit / 8] >> (7 - bit % 8)) & 1 : 0);
+
+			int symbol = symbol_of[value];
+			write(point_cos[symbol], point_sin[symbol], dst);
+		}
+	}
+
+	write(1, 0, dst);
+}
+
+void qam::write(double cos, double sin, std::vector<short>& dst) {
+	size_t idx = dst.size();
+
+	dst.insert(dst.end(), samples_per_baud, 0);
+
+	for (int i = 0; i < samples_per_baud; ++i) {
+		dst[idx + i] = max_volume * (_cos[i] * cos - _sin[i] * sin) * 0.9;
+	}
+}
\ No newline at end of file
@@ -3,18 +3,24 @@
 #include <cmath>
 #include <bitset>
 
-qpsk::qpsk(int sample_rate, int baud_rate) : modem_device(sample_rate, baud_rate) {
+qpsk::qpsk(int sample_rate, int baud_rate, int carrier, double volume, bool coded) : modem_device(sample_rate, baud_rate), carrier(carrier), volume(volume), coded(coded) {
 	samples_per_baud = 2 * sample_rate / baud_rate;
 	min_samples = 20 * samples_per_baud;
 	max_volume = INT16_MAX;
-	threshold = 0.5;
+	threshold = 0.5 * volume / 0.9;
 	received = 0;
+	weak = 0;
+	tolerance = 0;
+	ref_cos = 1;
+	ref_sin = 0;
+	pre_cos = 1;
+	pre_sin = 0;
 
 	_cos.assign(samples_per_baud, 0);
 	_sin.assign(samples_per_baud, 0);
 
 	for (int i = 0; i < samples_per_baud; ++i) {
-		double theta = 2 * pi * i / samples_per_baud;
+		double theta = 2 * pi * carrier * i / samples_per_baud;
 		_cos[i] = std::cos(theta);
 		_sin[i] = std::sin(theta);
 	}
@@ -38,6 +44,37 @@ void qpsk::phase(std::vector<short>& v, size_t idx, double& cos, double& sin, si
 	sin = sin * 2 / len;
 }
 
+size_t qpsk::align(std::vector<short>& v, size_t origin, long long step) {
+	// Above the first harmonic the preamble repeats every samples_per_baud / carrier samples,
+	// so choose the shift where a whole reference symbol is followed by a whole marker. That period is seldom a whole
+	// number of samples, and a sample off turns the reference by 2 * pi * carrier / samples_per_baud, so try every
+	// sample between the periods too. A window across a symbol edge of a multi-carrier signal picks up the other lanes
+	// and may come out stronger than a clean one, so score how far both symbols are from the preamble's own level.
+	size_t ret = origin + step * samples_per_baud / carrier;
+	double cos, sin, prev_cos, prev_sin;
+	double min_err = inf;
+	long long first = origin + std::max(step + 1 - carrier, 0LL) * samples_per_baud / carrier;
+	long long last = origin + (step + carrier - 1) * samples_per_baud / carrier;
+
+	// The search stopped within half a symbol of the marker, so the two symbols before it are reference.
+	phase(v, ret >= 3LL * samples_per_baud ? ret - 3 * samples_per_baud : origin, cos, sin, samples_per_baud * 2LL);
+	double level = std::sqrt(cos * cos + sin * sin);
+
+	for (long long i = std::max(first, (long long)samples_per_baud); i <= last; ++i) {
+		phase(v, i, cos, sin);
+		phase(v, i - samples_per_baud, prev_cos, prev_sin);
+		double err = (prev_cos - level) * (prev_cos - level) + prev_sin * prev_sin;
+		err += (cos + level * sqr) * (cos + level * sqr) + (sin + level * sqr) * (sin + level * sqr);
+
+		if (err < min_err) {
+			min_err = err;
+			ret = i;
+		}
+	}
+
+	return ret;
+}
+
 int qpsk::sync(std::vector<short>& v) {
 	if (v.size() < min_samples)
 		return -1;
@@ -66,7 +103,7 @@ int qpsk::sync(std::vector<short>& v) {
 	size_t max_idx = 0;
 	double max_val = -inf;
 
-	for (int i = idx; i < idx + samples_per_baud; ++i) {
+	for (int i = idx; i < idx + samples_per_baud / carrier; ++i) {
 		phase(v, i, cos, sin, samples_per_baud * 2LL);
 		double val = cos - std::abs(sin);
 
@@ -76,47 +113,114 @@ int qpsk::sync(std::vector<short>& v) {
 		}
 	}
 
-	for (idx = max_idx; idx + min_samples < v.size(); idx += samples_per_baud) {
+	// The repeat period is not a whole number of samples above the first harmonic, so count periods from max_idx.
+	idx = max_idx;
+
+	for (long long step = 0; max_idx + step * samples_per_baud / carrier + min_samples < v.size(); ++step) {
+		idx = max_idx + step * samples_per_baud / carrier;
 		phase(v, idx, cos, sin);
+
+		// The tone died out before any marker, so it was the tail of an earlier frame; look again from here. Noise
+		// alone rarely drags a reference symbol this low. A window across the marker loses power too, the more so when
+		// the other lanes of a multi-carrier modem turn with it, but whichever half of it misses the turn keeps the tone.
+		if (cos * cos + sin * sin < threshold * threshold / 4) {
+			double head_cos, head_sin, tail_cos, tail_sin;
+			phase(v, idx, head_cos, head_sin, samples_per_baud / 2);
+			phase(v, idx + samples_per_baud / 2, tail_cos, tail_sin, samples_per_baud / 2);
+
+			if (std::max(head_cos * head_cos + head_sin * head_sin, tail_cos * tail_cos + tail_sin * tail_sin) < threshold * threshold / 4) {
+				v.erase(v.begin(), v.begin() + idx);
+				return -1;
+			}
+		}
+
 		if (cos < 0 && sin < 0) {
+			idx = align(v, max_idx, step);
+
+			// At least one whole reference symbol precedes the marker, and usually two.
+			size_t len = idx >= 2LL * samples_per_baud ? 2 * samples_per_baud : samples_per_baud;
+			phase(v, idx - len, pre_cos, pre_sin, len);
+
 			v.erase(v.begin(), v.begin() + idx + samples_per_baud);
+			ref_cos = 1;
+			ref_sin = 0;
 			synchronized = true;
 			return 1;
 		}
 	}
 
-	v.erase(v.begin(), v.begin() + idx);
+	// Ran out of samples before the marker: keep the preamble for the next call unless it has gone on far too long.
+	size_t start = max_idx - std::min(max_idx, (size_t)samples_per_baud);
+	v.erase(v.begin(), v.begin() + (idx - start > 16LL * samples_per_baud ? idx : start));
 	return  -1;
 }
 
 int qpsk::demoulate(std::vector<short>& v, std::vector<char>& dst) {
+	std::vector<int8_t> llr;
+	return demoulate_soft(v, dst, llr);
+}
+
+int qpsk::demoulate_soft(std::vector<short>& v, std::vector<char>& dst, std::vector<int8_t>& llr) {
 	double cos, sin;
 	size_t idx;
 
 	for (idx = 0; idx + min_samples < v.size(); idx += samples_per_baud) {
 		phase(v, idx, cos, sin);
+		double c = cos * ref_cos + sin * ref_sin;
+		sin = sin * ref_cos - cos * ref_sin;
+		cos = c;
+
 		double power = std::sqrt(cos * cos + sin * sin);
 
-		if (power < threshold) {
+		// Coded frames, and any the modem set a tolerance for, ride out faint symbols as weak soft values.
+		weak = power < threshold ? weak + 1 : 0;
+
+		if (weak > std::max(coded ? max_weak : 0, tolerance)) {
 			synchronized = false;
+			weak = 0;
 			buff = "";
+			soft.clear();
 			received = 0;
 
 			v.erase(v.begin(), v.begin() + idx + samples_per_baud);
 			return -1;
 		}
 
-		buff += cos > 0 ? '1' : '0';
-		buff += sin > 0 ? '1' : '0';
+		soft.push_back((int8_t)std::round(max_llr * cos / std::max(power, threshold)));
+		soft.push_back((int8_t)std::round(max_llr * sin / std::max(power, threshold)));
+
+		if (!coded) {
+			buff += cos > 0 ? '1' : '0';
+			buff += sin > 0 ? '1' : '0';
+		}
+
+		// Clock offset turns into a slow phase walk that grows with the carrier, so follow it from the decisions.
+		double p_cos = cos > 0 ? 1 : -1, p_sin = sin > 0 ? 1 : -1;
+		double err = 0.05 * std::atan2(sin * p_cos - cos * p_sin, cos * p_cos + sin * p_sin);
+		double r = ref_cos * std::cos(err) - ref_sin * std::sin(err);
+		ref_sin = ref_cos * std::sin(err) + ref_sin * std::cos(err);
+		ref_cos = r;
 
 		if (buff.size() == 8) {
 			unsigned char c = std::bitset<8>(buff).to_ulong();
 			dst.push_back(c);
+			llr.insert(llr.end(), soft.begin(), soft.end());
+			soft.clear();
 			buff = "";
 			received += 1;
 		}
 
-		if (received == 128) {
+		// The code bits fill whole symbols, so a coded frame ends exactly on a symbol boundary.
+		if (coded && soft.size() == convolutional_code::coded_bits(frame_size)) {
+			size_t idx = dst.size();
+			dst.resize(idx + frame_size);
+			code.decode(soft.data(), frame_size, dst.data() + idx);
+			hard_llr(dst.data() + idx, frame_size, llr);
+			soft.clear();
+			received = frame_size;
+		}
+
+		if (received == frame_size) {
 			received = 0;
 			synchronized = false;
 			v.erase(v.begin(), v.begin() + idx + samples_per_baud);
@@ -133,7 +237,7 @@ void qpsk::modulate(char* src, size_t size, std::vector<short>& dst) {
 	double cos, sin;
 
 	for (int i = 0; i < size; ++i) {
-		if (i % 128 == 0) {
+		if (i % frame_size == 0) {
 			write(1, 0, dst);
 			write(1, 0, dst);
 			write(1, 0, dst);
@@ -141,6 +245,20 @@ void qpsk::modulate(char* src, size_t size, std::vector<short>& dst) {
 			write(1, 0, dst);
 			write(1, 0, dst);
 			write(-sqr, -sqr, dst);
+
+			if (coded) {
+				std::vector<char> block(src + i, src + std::min(size, (size_t)i + frame_size));
+				std::vector<uint8_t> bits;
+
+				block.resize(frame_size, 0);
+				code.encode(block.data(), frame_size, bits);
+
+				for (size_t b = 0; b < bits.size(); b += 2)
+					write(bits[b] ? sqr : -sqr, bits[b + 1] ? sqr : -sqr, dst);
+
+				i += frame_size - 1;
+				continue;
+			}
 		}
 
 		std::bitset<8> bits(src[i]);
@@ -162,6 +280,6 @@ void qpsk::write(double cos, double sin, std::vector<short>& dst) {
 	dst.insert(dst.end(), samples_per_baud, 0);
 
 	for (int i = 0; i < samples_per_baud; ++i) {
-		dst[idx + i] = max_volume * (_cos[i] * cos - _sin[i] * sin) * 0.9;
+		dst[idx + i] = max_volume * (_cos[i] * cos - _sin[i] * sin) * volume;
 	}
 }
\ No newline at end of file
@@ -0,0 +1,86 @@
+#include "radix2_fft.h"
+#include "modem_device.h"
+#include <cmath>
+#include <utility>
+
+radix2_fft::radix2_fft(int n) : n(n) {
+	int bits = 0;
+
+	while ((1 << bits) < n)
+		bits += 1;
+
+	reversed.assign(n, 0);
+
+	for (int i = 0; i < n; ++i) {
+		int r = 0;
+
+		for (int b = 0; b < bits; ++b) {
+			if (i & (1 << b))
+				r |= 1 << (bits - 1 - b);
+		}
+
+		reversed[i] = r;
+	}
+
+	// Twiddles of the stage with half length h are stored contiguously at [h, 2h).
+	w_re.assign(n, 0);
+	w_im.assign(n, 0);
+
+	for (int h = 1; h < n; h <<= 1) {
+		for (int j = 0; j < h; ++j) {
+			double theta = -pi * j / h;
+			w_re[h + j] = std::cos(theta);
+			w_im[h + j] = std::sin(theta);
+		}
+	}
+}
+
+void radix2_fft::transform(double* re, double* im) {
+	for (int i = 0; i < n; ++i) {
+		int r = reversed[i];
+
+		if (i < r) {
+			std::swap(re[i], re[r]);
+			std::swap(im[i], im[r]);
+		}
+	}
+
+	for (int h = 1; h < n; h <<= 1) {
+		const double* wr = w_re.data() + h;
+		const double* wi = w_im.data() + h;
+
+		for (int k = 0; k < n; k += 2 * h) {
+			double* ar = re + k, * ai = im + k;
+			double* br = re + k + h, * bi = im + k + h;
+
+			for (int j = 0; j < h; ++j) {
+				double tr = br[j] * wr[j] - bi[j] * wi[j];
+				double ti = br[j] * wi[j] + bi[j] * wr[j];
+
+				br[j] = ar[j] - tr;
+				bi[j] = ai[j] - ti;
+				ar[j] += tr;
+				ai[j] += ti;
+			}
+		}
+	}
+}
+
+void radix2_fft::forward(std::vector<double>& re, std::vector<double>& im) {
+	re.resize(n, 0);
+	im.resize(n, 0);
+
+	transform(re.data(), im.data());
+}
+
+void radix2_fft::inverse(std::vector<double>& re, std::vector<double>& im) {
+	re.resize(n, 0);
+	im.resize(n, 0);
+
+	transform(im.data(), re.data());
+
+	for (int i = 0; i < n; ++i) {
+		re[i] /= n;
+		im[i] /= n;
+	}
+}
\ No newline at end of file
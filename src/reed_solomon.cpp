@@ -0,0 +1,260 @@
+#include "reed_solomon.h"
+#include <cstring>
+#include <algorithm>
+#include <tmmintrin.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#define SSSE3_TARGET
+#else
+#include <cpuid.h>
+#define SSSE3_TARGET __attribute__((target("ssse3")))
+#endif
+
+struct galois_field {
+	uint8_t exp[512];
+	uint8_t log[256];
+
+	// Products of every constant with the low and high nibbles, laid out for pshufb.
+	alignas(16) uint8_t mul_lo[256][16];
+	alignas(16) uint8_t mul_hi[256][16];
+
+	// powers[p][j] = a^(j * p), what a byte p places from the end of a block adds to syndrome j.
+	alignas(16) uint8_t powers[255][32];
+
+	galois_field() {
+		int x = 1;
+
+		for (int i = 0; i < 255; ++i) {
+			exp[i] = exp[i + 255] = (uint8_t)x;
+			log[x] = (uint8_t)i;
+
+			x <<= 1;
+
+			if (x & 0x100)
+				x ^= 0x11d;
+		}
+
+		exp[510] = exp[511] = exp[0];
+		log[0] = 0;
+
+		for (int c = 0; c < 256; ++c) {
+			for (int n = 0; n < 16; ++n) {
+				mul_lo[c][n] = mul(c, n);
+				mul_hi[c][n] = mul(c, n << 4);
+			}
+		}
+
+		for (int p = 0; p < 255; ++p) {
+			for (int j = 0; j < 32; ++j)
+				powers[p][j] = exp[j * p % 255];
+		}
+	}
+
+	uint8_t mul(int a, int b) const { return a && b ? exp[log[a] + log[b]] : 0; }
+	uint8_t div(int a, int b) const { return a ? exp[log[a] + 255 - log[b]] : 0; }
+	uint8_t pow(int e) const { return exp[(e % 255 + 255) % 255]; }
+};
+
+// Built on first use, so codecs constructed during static initialization elsewhere still see the tables.
+static const galois_field& field() {
+	static const galois_field instance;
+	return instance;
+}
+
+static bool has_ssse3() {
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 1);
+	return (info[2] >> 9) & 1;
+#else
+	unsigned int a, b, c, d;
+	return __get_cpuid(1, &a, &b, &c, &d) && ((c >> 9) & 1);
+#endif
+}
+
+static const bool vectorized = has_ssse3();
+
+// Each byte adds itself times a fixed vector of powers to all 32 syndromes; that product is two nibble lookups per lane.
+SSSE3_TARGET static void syndromes_ssse3(const uint8_t* block, size_t len, uint8_t* dst) {
+	const galois_field& gf = field();
+	const __m128i mask = _mm_set1_epi8(0x0f);
+	__m128i s0 = _mm_setzero_si128(), s1 = _mm_setzero_si128();
+
+	for (size_t t = 0; t < len; ++t) {
+		uint8_t c = block[t];
+
+		if (c == 0)
+			continue;
+
+		const __m128i lo = _mm_load_si128((const __m128i*)gf.mul_lo[c]);
+		const __m128i hi = _mm_load_si128((const __m128i*)gf.mul_hi[c]);
+		const __m128i* p = (const __m128i*)gf.powers[len - 1 - t];
+		__m128i v0 = _mm_load_si128(p), v1 = _mm_load_si128(p + 1);
+
+		s0 = _mm_xor_si128(s0, _mm_xor_si128(_mm_shuffle_epi8(lo, _mm_and_si128(v0, mask)), _mm_shuffle_epi8(hi, _mm_and_si128(_mm_srli_epi16(v0, 4), mask))));
+		s1 = _mm_xor_si128(s1, _mm_xor_si128(_mm_shuffle_epi8(lo, _mm_and_si128(v1, mask)), _mm_shuffle_epi8(hi, _mm_and_si128(_mm_srli_epi16(v1, 4), mask))));
+	}
+
+	_mm_storeu_si128((__m128i*)dst, s0);
+	_mm_storeu_si128((__m128i*)(dst + 16), s1);
+}
+
+reed_solomon::reed_solomon(int parity) : parity(std::min(std::max(parity, 2), max_parity)) {
+	const galois_field& gf = field();
+
+	// g(x) = (x - a^0)(x - a^1)...(x - a^(parity - 1)), highest power first.
+	memset(generator, 0, sizeof(generator));
+	generator[0] = 1;
+
+	for (int j = 0; j < this->parity; ++j) {
+		uint8_t root = gf.pow(j);
+
+		for (int i = j + 1; i > 0; --i)
+			generator[i] ^= gf.mul(generator[i - 1], root);
+	}
+}
+
+void reed_solomon::encode(const uint8_t* msg, size_t len, uint8_t* dst) {
+	const galois_field& gf = field();
+	memset(dst, 0, parity);
+
+	for (size_t t = 0; t < len; ++t) {
+		uint8_t feedback = msg[t] ^ dst[0];
+
+		memmove(dst, dst + 1, parity - 1);
+		dst[parity - 1] = 0;
+
+		if (feedback == 0)
+			continue;
+
+		for (int i = 0; i < parity; ++i)
+			dst[i] ^= gf.mul(feedback, generator[i + 1]);
+	}
+}
+
+void reed_solomon::syndromes(const uint8_t* block, size_t len, uint8_t* dst) {
+	const galois_field& gf = field();
+	if (vectorized) {
+		syndromes_ssse3(block, len, dst);
+		return;
+	}
+
+	memset(dst, 0, max_parity);
+
+	for (size_t t = 0; t < len; ++t) {
+		if (block[t] == 0)
+			continue;
+
+		for (int j = 0; j < parity; ++j)
+			dst[j] ^= gf.mul(block[t], gf.powers[len - 1 - t][j]);
+	}
+}
+
+int reed_solomon::decode(uint8_t* block, size_t len, const size_t* erasures, int count) {
+	const galois_field& gf = field();
+	uint8_t s[max_parity];
+
+	if (len <= (size_t)parity || len > 255 || count > parity)
+		return -1;
+
+	syndromes(block, len, s);
+
+	if (std::all_of(s, s + parity, [](uint8_t x) { return x == 0; }))
+		return 0;
+
+	// Berlekamp-Massey: the shortest LFSR that generates the syndromes gives the error locator, lowest power first.
+	// Starting from the erasure locator, the product of (1 - X x) over the erased positions, makes it find the rest.
+	uint8_t locator[max_parity + 1] = { 1 }, prev[max_parity + 1], tmp[max_parity + 1];
+	int errors = count, shift = 1;
+	uint8_t last = 1;
+
+	for (int k = 0; k < count; ++k) {
+		if (erasures[k] >= len)
+			return -1;
+
+		uint8_t x = gf.pow(len - 1 - erasures[k]);
+
+		for (int i = k + 1; i > 0; --i)
+			locator[i] ^= gf.mul(locator[i - 1], x);
+	}
+
+	memcpy(prev, locator, sizeof(prev));
+
+	for (int n = count; n < parity; ++n) {
+		uint8_t d = s[n];
+
+		for (int i = 1; i <= errors; ++i)
+			d ^= gf.mul(locator[i], s[n - i]);
+
+		if (d == 0) {
+			shift += 1;
+			continue;
+		}
+
+		uint8_t scale = gf.div(d, last);
+		memcpy(tmp, locator, sizeof(tmp));
+
+		for (int i = 0; i + shift <= parity; ++i)
+			locator[i + shift] ^= gf.mul(scale, prev[i]);
+
+		if (2 * errors <= n + count) {
+			errors = n + 1 + count - errors;
+			memcpy(prev, tmp, sizeof(prev));
+			last = d;
+			shift = 1;
+		}
+
+		else
+			shift += 1;
+	}
+
+	if (2 * errors - count > parity)
+		return -1;
+
+	// Omega(x) = S(x) * Lambda(x) mod x^parity.
+	uint8_t evaluator[max_parity] = { 0 };
+
+	for (int i = 0; i < parity; ++i) {
+		for (int j = 0; j <= std::min(i, errors); ++j)
+			evaluator[i] ^= gf.mul(locator[j], s[i - j]);
+	}
+
+	// Chien search over the positions the shortened block actually has, then Forney for each magnitude.
+	int found = 0;
+	size_t positions[max_parity];
+	uint8_t values[max_parity];
+
+	for (int p = 0; p < (int)len && found <= errors; ++p) {
+		uint8_t sum = 0;
+
+		for (int i = 0; i <= errors; ++i)
+			sum ^= gf.mul(locator[i], gf.pow(-p * i));
+
+		if (sum != 0)
+			continue;
+
+		uint8_t omega = 0, derivative = 0;
+
+		for (int i = 0; i < parity; ++i)
+			omega ^= gf.mul(evaluator[i], gf.pow(-p * i));
+
+		for (int i = 1; i <= errors; i += 2)
+			derivative ^= gf.mul(locator[i], gf.pow(-p * (i - 1)));
+
+		if (derivative == 0 || found == errors)
+			return -1;
+
+		positions[found] = len - 1 - p;
+		values[found] = gf.mul(gf.pow(p), gf.div(omega, derivative));
+		found += 1;
+	}
+
+	if (found != errors)
+		return -1;
+
+	for (int k = 0; k < found; ++k)
+		block[positions[k]] ^= values[k];
+
+	return found;
+}
\ No newline at end of file
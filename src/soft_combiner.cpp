@@ -0,0 +1,89 @@
+#include "soft_combiner.h"
+#include <algorithm>
+#include <cstring>
+
+double soft_combiner::agreement(const std::vector<int16_t>& sum, const int8_t* llr) {
+	size_t same = 0, counted = 0;
+
+	// Erased bits say nothing either way, and a match needs at least half the frame to go on.
+	for (size_t i = 0; i < frame_size * 8; ++i) {
+		if (sum[i] == 0 || llr[i] == 0)
+			continue;
+
+		counted += 1;
+		same += (sum[i] > 0) == (llr[i] > 0);
+	}
+
+	return counted >= frame_size * 4 ? (double)same / counted : 0;
+}
+
+// Id, type and seq have to agree bit for bit wherever neither copy is erased, and enough of them must be there to tell.
+bool soft_combiner::same_header(const std::vector<int16_t>& sum, const int8_t* llr) {
+	size_t counted = 0;
+
+	for (size_t i = 0; i < header_bits; ++i) {
+		if (sum[i] == 0 || llr[i] == 0)
+			continue;
+
+		if ((sum[i] > 0) != (llr[i] > 0))
+			return false;
+
+		counted += 1;
+	}
+
+	return counted >= header_bits / 2;
+}
+
+bool soft_combiner::combine(char* frame, const int8_t* llr, fec_scheme scheme) {
+	// A false sync or a frame lost early is mostly erased; keeping it would only push out frames worth combining.
+	if (std::count(llr, llr + frame_size * 8, 0) > (long)frame_size * 4)
+		return false;
+
+	std::vector<double> score(kept.size());
+	candidates.clear();
+
+	for (size_t k = 0; k < kept.size(); ++k) {
+		score[k] = agreement(kept[k], llr);
+
+		if (score[k] >= min_agreement)
+			candidates.push_back(k);
+	}
+
+	std::sort(candidates.begin(), candidates.end(), [&](size_t a, size_t b) { return score[a] > score[b]; });
+
+	for (size_t k : candidates) {
+		for (size_t i = 0; i < frame_size * 8; ++i)
+			combined[i] = (int8_t)std::min(std::max(kept[k][i] + llr[i], -(int)max_llr), (int)max_llr);
+
+		memset(frame, 0, frame_size);
+
+		for (size_t i = 0; i < frame_size * 8; ++i)
+			frame[i / 8] |= (combined[i] > 0) << (7 - i % 8);
+
+		bool intact = scheme != fec_scheme::none ? repair_frame(frame, combined.data(), scheme) : frame_intact(frame);
+
+		if (intact) {
+			kept.erase(kept.begin() + k);
+			return true;
+		}
+	}
+
+	// Still short: fold this copy into the closest match with the same header so a third one starts from both, or keep
+	// it on its own.
+	for (size_t k : candidates) {
+		if (!same_header(kept[k], llr))
+			continue;
+
+		for (size_t i = 0; i < frame_size * 8; ++i)
+			kept[k][i] += llr[i];
+
+		return false;
+	}
+
+	kept.emplace_back(llr, llr + frame_size * 8);
+
+	if (kept.size() > max_kept)
+		kept.pop_front();
+
+	return false;
+}
\ No newline at end of file
@@ -0,0 +1,165 @@
+#include "text_dictionary.h"
+
+// Sample chat traffic. A short message rarely repeats itself, but it usually repeats phrases from here.
+const char text_dictionary[] =
+	"hello, can you hear me? "
+	"Hi, I can hear you loud and clear. "
+	"can you hear me now? "
+	"yes I can hear you "
+	"I can't hear you very well, the signal is weak. "
+	"the signal is very weak on my side "
+	"signal is good now "
+	"Signal looks good, go ahead. "
+	"go ahead "
+	"ok, sending the file now "
+	"I'm sending you the file now. "
+	"did you get the file? "
+	"Did you receive the file? "
+	"I received the file, thanks! "
+	"file received, thank you "
+	"the file is corrupted, can you send it again? "
+	"can you send it again please? "
+	"please send it again "
+	"please try again "
+	"let's try again with a lower baud rate "
+	"try a lower baud rate "
+	"what baud rate are you using? "
+	"I'm using 1225 baud with FSK "
+	"switching to QPSK now "
+	"let's switch to FSK, it is more robust "
+	"turn on error correction "
+	"error correction is on "
+	"I turned on LDPC "
+	"are you using Reed-Solomon or LDPC? "
+	"what is your sample rate? "
+	"48000 Hz here "
+	"the volume is too low "
+	"turn up the volume please "
+	"can you turn down the volume a bit? "
+	"the volume is too high, it's clipping "
+	"there is a lot of noise in the room "
+	"it's too noisy here, one moment "
+	"one moment please "
+	"wait a moment "
+	"wait a second "
+	"sorry, I missed that "
+	"sorry, could you repeat that? "
+	"what did you say? "
+	"I didn't get that "
+	"I don't understand "
+	"ok, got it "
+	"OK thanks "
+	"thanks a lot "
+	"thank you very much "
+	"no problem "
+	"you're welcome "
+	"good morning "
+	"good afternoon "
+	"good evening "
+	"good night "
+	"see you later "
+	"see you tomorrow "
+	"talk to you later "
+	"bye for now "
+	"how are you? "
+	"how are you doing today? "
+	"I'm fine, thank you. And you? "
+	"I'm doing well, thanks for asking. "
+	"what are you doing? "
+	"where are you? "
+	"I'm at home "
+	"I'm in the office "
+	"I will be there in ten minutes "
+	"are you there? "
+	"are you still there? "
+	"yes, I'm still here "
+	"I'm here "
+	"is this working? "
+	"it works! "
+	"it is working now "
+	"it's not working "
+	"it doesn't work on my computer "
+	"something is wrong with the audio device "
+	"I think the microphone is broken "
+	"the speaker is too far from the microphone "
+	"move the microphone closer to the speaker "
+	"let me check the settings "
+	"let me restart the program "
+	"I restarted the demodulation service "
+	"the audio stream stopped "
+	"please start the audio stream again "
+	"testing, testing, one two three "
+	"this is a test message "
+	"this is a test "
+	"test message number two "
+	"test 1 2 3 "
+	"the quick brown fox jumps over the lazy dog "
+	"what time is it? "
+	"it is almost five o'clock "
+	"when can we start? "
+	"we can start now "
+	"let's start "
+	"let's begin "
+	"are you ready? "
+	"I'm ready "
+	"ready when you are "
+	"not yet, give me a minute "
+	"give me a few minutes "
+	"do you have the latest version of the file? "
+	"I updated the file, I'll send the new version "
+	"I will send you the new version of the document "
+	"please check the document and let me know what you think "
+	"let me know if you have any questions "
+	"let me know when you are done "
+	"I'm done "
+	"all done "
+	"that's all for today "
+	"that's it for now "
+	"see you next time "
+	"I have a question "
+	"what do you think? "
+	"I think so "
+	"I don't think so "
+	"maybe later "
+	"sounds good "
+	"sounds great "
+	"that sounds good to me "
+	"great, thanks "
+	"perfect "
+	"awesome "
+	"cool "
+	"nice "
+	"yes "
+	"no "
+	"okay "
+	"sure "
+	"of course "
+	"why not? "
+	"why? "
+	"how? "
+	"what about you? "
+	"me too "
+	"same here "
+	"I agree "
+	"I'm not sure "
+	"I have no idea "
+	"never mind "
+	"don't worry "
+	"it doesn't matter "
+	"the connection is unstable "
+	"we lost the connection "
+	"the connection is back "
+	"packet lost, please resend "
+	"the packet was lost "
+	"received all packets "
+	"transmission completed "
+	"how long does it take to send a file? "
+	"it takes about a minute for a small file "
+	"the transfer is very slow "
+	"the transfer is faster now "
+	"could you please send me the log file? "
+	"I'll export the log and send it to you "
+	"here is the configuration file "
+	"I changed the configuration ";
+
+const size_t text_dictionary_size = sizeof(text_dictionary) - 1;
\ No newline at end of file
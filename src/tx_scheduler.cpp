@@ -0,0 +1,100 @@
+#include "tx_scheduler.h"
+#include "frame.h"
+
+bool tx_scheduler::empty() {
+	for (auto& queue : queues) {
+		if (!queue.empty())
+			return false;
+	}
+
+	return true;
+}
+
+void tx_scheduler::push(std::vector<char>&& data, tx_priority priority, std::function<void(bool)> callback, size_t payload) {
+	std::vector<uint16_t> seqs(frame_count(data.size(), payload));
+
+	for (size_t i = 0; i < seqs.size(); ++i)
+		seqs[i] = (uint16_t)i;
+
+	queues[(int)priority].push_back(entry{ std::move(data), std::move(callback), std::move(seqs), 0, payload, false, nullptr });
+}
+
+void tx_scheduler::resend(const std::vector<char>& data, std::vector<uint16_t>&& seqs, tx_priority priority, size_t payload) {
+	if (seqs.empty())
+		return;
+
+	queues[(int)priority].push_back(entry{ data, nullptr, std::move(seqs), 0, payload, false, nullptr });
+}
+
+void tx_scheduler::push_frame(std::vector<char>&& frame, tx_priority priority) {
+	queues[(int)priority].push_back(entry{ std::move(frame), nullptr, {}, 0, frame_payload_size, true, nullptr });
+}
+
+void tx_scheduler::push_stream(std::function<void(std::vector<char>&)> source, tx_priority priority) {
+	queues[(int)priority].push_back(entry{ {}, nullptr, {}, 0, frame_payload_size, false, std::move(source) });
+}
+
+void tx_scheduler::end_streams() {
+	for (auto& queue : queues) {
+		for (auto it = queue.begin(); it != queue.end();) {
+			if (it->source)
+				it = queue.erase(it);
+
+			else
+				++it;
+		}
+	}
+}
+
+bool tx_scheduler::pop(std::vector<char>& frame, std::function<void(bool)>& callback) {
+	for (auto& queue : queues) {
+		if (queue.empty())
+			continue;
+
+		entry e = std::move(queue.front());
+		queue.pop_front();
+
+		if (e.framed) {
+			frame.insert(frame.end(), e.data.begin(), e.data.end());
+			callback = std::move(e.callback);
+
+			return true;
+		}
+
+		if (e.source) {
+			e.source(frame);
+			queue.push_back(std::move(e));
+
+			return true;
+		}
+
+		build_frame(e.data, e.seqs[e.next], frame, e.payload);
+		e.next += 1;
+
+		if (e.next == e.seqs.size())
+			callback = std::move(e.callback);
+
+		else
+			queue.push_back(std::move(e));
+
+		return true;
+	}
+
+	return false;
+}
+
+void tx_scheduler::clear() {
+	std::vector<std::function<void(bool)>> callbacks;
+
+	for (auto& queue : queues) {
+		for (auto& e : queue) {
+			if (e.callback)
+				callbacks.push_back(std::move(e.callback));
+		}
+
+		queue.clear();
+	}
+
+	for (auto& callback : callbacks)
+		callback(false);
+}
\ No newline at end of file
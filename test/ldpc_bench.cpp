@@ -0,0 +1,74 @@
+#include "ldpc.h"
+#include "reed_solomon.h"
+#include "frame.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <chrono>
+#include <random>
+#include <algorithm>
+
+// Frame error rates of the 1024-bit rate 3/4 LDPC code on soft decisions and of RS(128,96) on hard ones, both
+// filling a 128-byte frame, over a BPSK channel with white noise. Pass a frame count per point to trade run time
+// for precision.
+static constexpr size_t data_size = 96;
+
+static double bpsk(std::mt19937& engine, std::normal_distribution<double>& noise, const uint8_t* src, size_t bit) {
+	return ((src[bit / 8] >> (7 - bit % 8)) & 1 ? 1 : -1) + noise(engine);
+}
+
+int main(int argc, char** argv) {
+	int frames = argc > 1 ? atoi(argv[1]) : 1000;
+	ldpc_code ldpc(32, ldpc_rate::three_quarters);
+	reed_solomon rs(frame_size - data_size);
+	std::mt19937 engine(11);
+	std::vector<uint8_t> block(frame_size), coded(frame_size), hard(frame_size), dst(frame_size);
+	std::vector<int8_t> llr(frame_size * 8);
+
+	printf("%d frames per point\n", frames);
+	printf("Eb/N0 dB  LDPC FER    RS FER  LDPC us/frame  LDPC Mbit/s\n");
+
+	for (double ebn0 = 2.0; ebn0 <= 6.01; ebn0 += 0.5) {
+		double rate = (double)data_size / frame_size;
+		std::normal_distribution<double> noise(0, std::sqrt(1 / (2 * rate * std::pow(10, ebn0 / 10))));
+		int ldpc_errors = 0, rs_errors = 0;
+		double seconds = 0;
+
+		for (int i = 0; i < frames; ++i) {
+			for (size_t j = 0; j < data_size; ++j)
+				block[j] = (uint8_t)engine();
+
+			// LDPC on clipped soft values, scaled the way the demodulators report them.
+			coded = block;
+			ldpc.encode(coded.data(), coded.data() + data_size);
+
+			for (size_t b = 0; b < frame_size * 8; ++b)
+				llr[b] = (int8_t)std::lround(std::max(-1.0, std::min(1.0, bpsk(engine, noise, coded.data(), b) / 2)) * 127);
+
+			auto start = std::chrono::steady_clock::now();
+			ldpc.decode(llr.data(), dst.data());
+			seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			ldpc_errors += memcmp(dst.data(), block.data(), data_size) != 0;
+
+			// Reed-Solomon on hard decisions of the same channel.
+			coded = block;
+			rs.encode(coded.data(), data_size, coded.data() + data_size);
+			std::fill(hard.begin(), hard.end(), 0);
+
+			for (size_t b = 0; b < frame_size * 8; ++b) {
+				if (bpsk(engine, noise, coded.data(), b) > 0)
+					hard[b / 8] |= 1 << (7 - b % 8);
+			}
+
+			rs.decode(hard.data(), frame_size);
+			rs_errors += memcmp(hard.data(), block.data(), data_size) != 0;
+		}
+
+		printf("%8.1f %9.3f %9.3f %14.1f %12.1f\n", ebn0, (double)ldpc_errors / frames, (double)rs_errors / frames,
+			seconds / frames * 1e6, frames * data_size * 8 / seconds / 1e6);
+	}
+
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,116 @@
+#include "modem_device.h"
+#include <cstdio>
+#include <random>
+#include <algorithm>
+
+// Noiseless loopback of the multi-carrier modems. Every lane has to find its own preamble among the others and keep
+// clear of their tones, so on a clean channel every frame must come back, and nothing that was not sent.
+static constexpr int sample_rate = 48000;
+
+// Feeds the signal in the blocks the demodulation loop sees, and keeps only whole frames, as it does.
+static std::vector<char> receive(modem_device* rx, const std::vector<short>& signal) {
+	std::vector<short> v;
+	std::vector<char> received, dst;
+
+	for (size_t pos = 0; pos < signal.size(); pos += 2048) {
+		v.insert(v.end(), signal.begin() + pos, signal.begin() + std::min(signal.size(), pos + 2048));
+
+		if (v.size() < 4096)
+			continue;
+
+		if (!rx->is_synchronized()) {
+			rx->sync(v);
+			continue;
+		}
+
+		int ret = rx->demoulate(v, received);
+		size_t whole = received.size() / frame_size * frame_size;
+
+		dst.insert(dst.end(), received.begin(), received.begin() + whole);
+		received.erase(received.begin(), received.begin() + whole);
+
+		if (ret == -1)
+			received.clear();
+	}
+
+	return dst;
+}
+
+// Sends `bursts` bursts of one frame per lane, with `gap` samples of silence before each. Lanes finish their frames
+// in no set order, so frames are matched by content. Returns the frames lost, or -1 if a wrong frame came out.
+static int loopback(modem_type type, int baud_rate, size_t gap, int bursts, int& frames) {
+	modem_device* tx = modem_device::new_device(type, sample_rate, baud_rate);
+	modem_device* rx = modem_device::new_device(type, sample_rate, baud_rate);
+	std::mt19937 engine((unsigned)(gap * 7 + baud_rate));
+	size_t burst = tx->frame_length();
+	std::vector<char> src(bursts * burst);
+	std::vector<short> signal;
+
+	for (auto& c : src)
+		c = (char)engine();
+
+	for (int i = 0; i < bursts; ++i) {
+		signal.insert(signal.end(), gap, 0);
+		tx->modulate(src.data() + i * burst, burst, signal);
+	}
+
+	signal.insert(signal.end(), 16384, 0);
+
+	std::vector<char> dst = receive(rx, signal);
+	std::vector<bool> found(src.size() / frame_size, false);
+	int lost = 0;
+
+	frames = (int)found.size();
+
+	delete tx;
+	delete rx;
+
+	for (size_t i = 0; i + frame_size <= dst.size(); i += frame_size) {
+		size_t j = 0;
+
+		while (j < found.size() && (found[j] || !std::equal(dst.begin() + i, dst.begin() + i + frame_size, src.begin() + j * frame_size)))
+			++j;
+
+		if (j == found.size())
+			return -1;
+
+		found[j] = true;
+	}
+
+	for (bool f : found)
+		lost += !f;
+
+	return lost;
+}
+
+int main() {
+	struct { modem_type type; const char* name; } modems[] = {
+		{ modem_type::fsk_multi, "FSK-MC" },
+		{ modem_type::qpsk_multi, "QPSK-MC" },
+	};
+
+	int bauds[] = { 300, 600, 800, 1000, 1225, 1600, 2400 };
+	int bursts = 12;
+	bool failed = false;
+
+	for (auto& m : modems) {
+		for (int baud : bauds) {
+			for (size_t gap : { 0, 37, 500, 1000, 2000, 4321, 7777 }) {
+				int frames;
+				int lost = loopback(m.type, baud, gap, bursts, frames);
+
+				if (lost < 0)
+					printf("%-8s %5d baud, gap %4zu: a frame came out that was never sent\n", m.name, baud, gap);
+
+				else
+					printf("%-8s %5d baud, gap %4zu: %d/%d frames lost\n", m.name, baud, gap, lost, frames);
+
+				failed |= lost != 0;
+			}
+		}
+	}
+
+	printf("%s\n", failed ? "FAIL" : "ok");
+
+	return failed ? 1 : 0;
+}
\ No newline at end of file
@@ -0,0 +1,102 @@
+#include "modem_device.h"
+#include <cstdio>
+#include <random>
+#include <algorithm>
+
+// Noiseless loopback of the modems that share the QPSK preamble. The receiver has to find the preamble wherever the
+// block boundaries fall, after any length of silence and across gaps between frames, and must never hand back a frame
+// that was not sent.
+static constexpr int sample_rate = 48000;
+
+// Feeds the signal in the blocks the demodulation loop sees, and keeps only whole frames, as it does.
+static std::vector<char> receive(modem_device* rx, const std::vector<short>& signal) {
+	std::vector<short> v;
+	std::vector<char> received, dst;
+
+	for (size_t pos = 0; pos < signal.size(); pos += 2048) {
+		v.insert(v.end(), signal.begin() + pos, signal.begin() + std::min(signal.size(), pos + 2048));
+
+		if (v.size() < 4096)
+			continue;
+
+		if (!rx->is_synchronized()) {
+			rx->sync(v);
+			continue;
+		}
+
+		int ret = rx->demoulate(v, received);
+		size_t whole = received.size() / frame_size * frame_size;
+
+		dst.insert(dst.end(), received.begin(), received.begin() + whole);
+		received.erase(received.begin(), received.begin() + whole);
+
+		if (ret == -1)
+			received.clear();
+	}
+
+	return dst;
+}
+
+// Sends the frames one modulate call each, with `lead` samples of silence first and `gap` between frames.
+static bool loopback(modem_type type, int baud_rate, size_t lead, size_t gap, int frames) {
+	modem_device* tx = modem_device::new_device(type, sample_rate, baud_rate);
+	modem_device* rx = modem_device::new_device(type, sample_rate, baud_rate);
+	std::mt19937 engine((unsigned)(lead * 31 + gap + baud_rate));
+	std::vector<char> src(frames * frame_size);
+	std::vector<short> signal(lead, 0);
+
+	for (auto& c : src)
+		c = (char)engine();
+
+	for (int i = 0; i < frames; ++i) {
+		tx->modulate(src.data() + i * frame_size, frame_size, signal);
+		signal.insert(signal.end(), gap, 0);
+	}
+
+	signal.insert(signal.end(), 16384, 0);
+
+	std::vector<char> dst = receive(rx, signal);
+
+	delete tx;
+	delete rx;
+
+	return dst == src;
+}
+
+int main() {
+	struct { modem_type type; const char* name; } modems[] = {
+		{ modem_type::qpsk, "QPSK" },
+		{ modem_type::psk8, "8PSK" },
+		{ modem_type::qam16, "16QAM" },
+	};
+
+	int bauds[] = { 600, 800, 1225, 2400 };
+	int failed = 0, total = 0;
+
+	for (auto& m : modems) {
+		for (int baud : bauds) {
+			int bad = 0, runs = 0;
+
+			// Lead-ins from none to well past a whole block, at offsets that do not line up with a symbol.
+			for (size_t lead = 0; lead <= 8192; lead += 409, ++runs)
+				bad += !loopback(m.type, baud, lead, 0, 1);
+
+			// Frames back to back after two whole blocks of silence, then frames with gaps shorter and longer than a symbol.
+			bad += !loopback(m.type, baud, 8192, 0, 8);
+			runs += 1;
+
+			for (size_t gap : { 37, 100, 500, 2000, 5000 }) {
+				bad += !loopback(m.type, baud, 1000, gap, 4);
+				runs += 1;
+			}
+
+			printf("%-6s %5d baud: %d/%d runs failed\n", m.name, baud, bad, runs);
+			failed += bad;
+			total += runs;
+		}
+	}
+
+	printf("%s: %d/%d runs failed\n", failed ? "FAIL" : "ok", failed, total);
+
+	return failed ? 1 : 0;
+}
\ No newline at end of file
@@ -0,0 +1,135 @@
+#include "convolutional.h"
+#include "modem_device.h"
+#include "frame.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <chrono>
+#include <random>
+#include <algorithm>
+
+// Decoding speed of the K=7 Viterbi decoder, and frame error rates of the coded and plain FSK and QPSK modems over
+// white noise. Pass a frame count per point to trade run time for precision.
+static constexpr int sample_rate = 48000;
+static constexpr int baud_rate = 1200;
+
+static double throughput() {
+	convolutional_code code;
+	std::mt19937 engine(1);
+	std::normal_distribution<double> noise(0, 0.5);
+	std::vector<uint8_t> bits;
+	std::vector<int8_t> soft;
+	char src[frame_size], dst[frame_size];
+	int rounds = 5000;
+
+	for (auto& c : src)
+		c = (char)engine();
+
+	code.encode(src, frame_size, bits);
+
+	for (uint8_t b : bits)
+		soft.push_back((int8_t)std::max(-127.0, std::min(127.0, std::round(((b ? 1 : -1) + noise(engine)) * 40))));
+
+	auto start = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < rounds; ++i)
+		code.decode(soft.data(), frame_size, dst);
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	return rounds * frame_size * 8 / seconds / 1e6;
+}
+
+// Runs the frames through a fresh receiver the way the demodulation loop does, and counts the ones that come out
+// whole. The noise power is set against the power of the modulated signal.
+static double frame_errors(modem_type type, double snr_db, int frames) {
+	modem_device* tx = modem_device::new_device(type, sample_rate, baud_rate);
+	modem_device* rx = modem_device::new_device(type, sample_rate, baud_rate);
+	std::mt19937 engine(7);
+	std::vector<char> src(frames * frame_size), dst;
+	std::vector<short> modulated, signal(4096, 0), v;
+
+	for (auto& c : src)
+		c = (char)engine();
+
+	// A frame at a time, with silence between, so each one has to be acquired on its own.
+	for (int i = 0; i < frames; ++i) {
+		modulated.clear();
+		tx->modulate(src.data() + i * frame_size, frame_size, modulated);
+		signal.insert(signal.end(), modulated.begin(), modulated.end());
+		signal.insert(signal.end(), 4096, 0);
+	}
+
+	double power = 0;
+
+	for (short s : modulated)
+		power += (double)s * s;
+
+	power /= modulated.size();
+	std::normal_distribution<double> noise(0, std::sqrt(power / std::pow(10, snr_db / 10)));
+
+	for (auto& s : signal)
+		s = (short)std::max(-32767.0, std::min(32767.0, s + noise(engine)));
+
+	for (size_t pos = 0; pos < signal.size(); pos += 2048) {
+		v.insert(v.end(), signal.begin() + pos, signal.begin() + std::min(signal.size(), pos + 2048));
+
+		if (v.size() < 4096)
+			continue;
+
+		if (!rx->is_synchronized()) {
+			rx->sync(v);
+			continue;
+		}
+
+		if (rx->demoulate(v, dst) == -1)
+			dst.resize(dst.size() / frame_size * frame_size);
+	}
+
+	int good = 0;
+
+	for (size_t i = 0; i + frame_size <= dst.size(); i += frame_size) {
+		for (int j = 0; j < frames; ++j) {
+			if (std::equal(dst.begin() + i, dst.begin() + i + frame_size, src.begin() + j * frame_size)) {
+				good += 1;
+				break;
+			}
+		}
+	}
+
+	delete tx;
+	delete rx;
+
+	return 1.0 - (double)std::min(good, frames) / frames;
+}
+
+int main(int argc, char** argv) {
+	int frames = argc > 1 ? atoi(argv[1]) : 20;
+
+	struct { modem_type type; const char* name; } modems[] = {
+		{ modem_type::fsk, "FSK" },
+		{ modem_type::fsk_coded, "FSK-CC" },
+		{ modem_type::qpsk, "QPSK" },
+		{ modem_type::qpsk_coded, "QPSK-CC" },
+	};
+
+	printf("Viterbi decode: %.1f Mbit/s\n\n", throughput());
+	printf("frame error rate, %d frames per point, %d baud\n", frames, baud_rate);
+	printf("SNR dB");
+
+	for (auto& m : modems)
+		printf("%9s", m.name);
+
+	printf("\n");
+
+	for (double snr = -4; snr <= 6; snr += 1) {
+		printf("%6.0f", snr);
+
+		for (auto& m : modems)
+			printf("%9.2f", frame_errors(m.type, snr, frames));
+
+		printf("\n");
+	}
+
+	return 0;
+}
\ No newline at end of file